@@ -2,6 +2,7 @@
 #define EVERYTHING_H
 
 #include <stdalign.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -33,6 +34,7 @@ typedef struct {
     isize          align;
     void *         old_ptr;
     isize          old_size;
+    bool           zero;     // Whether bytes past `old_size` must read as 0.
 } Allocator_Proc_Args;
 
 typedef void *(*Allocator_Proc)(void *udata, const Allocator_Proc_Args *args);
@@ -24,8 +24,8 @@ static void *heap_allocator_proc(void *udata, const Allocator_Proc_Args *args)
             cast(byte *)new_ptr + args->old_size,
             args->new_size - args->old_size
         };
-        // Zero out the new region, only if we grew.
-        if (region.len > 0) {
+        // Zero out the new region, only if we grew and were asked to.
+        if (args->zero && region.len > 0) {
             memset(region.data, 0, region.len);
         }
         break;
@@ -42,8 +42,8 @@ static const Allocator heap_allocator = {&heap_allocator_proc, NULL};
 static void string_builder_print(const String_Builder *self)
 {
     const Dynamic_Header *hd = &self->header;
-    printf("String_Builder{header{len=%ti, cap=%ti}, data=\"%s\"}\n",
-            hd->len, hd->cap, self->data);
+    printf("String_Builder{header{len=%ti, cap=%ti}, data=\"%.*s\"}\n",
+            hd->len, hd->cap, cast(int)hd->len, self->data);
 }
 
 int main(void)
@@ -72,6 +72,7 @@ void *raw_alloc(const Allocator *a, isize new_size, isize align)
     args.align    = align;
     args.old_ptr  = NULL;
     args.old_size = 0;
+    args.zero     = false;
     return a->procedure(a->userdata, &args);
 }
 
@@ -83,6 +84,7 @@ void *raw_resize(const Allocator *a, void *old_ptr, isize old_size, isize new_si
     args.align    = align;
     args.old_ptr  = old_ptr;
     args.old_size = old_size;
+    args.zero     = false;
     return a->procedure(a->userdata, &args);
 }
 
@@ -94,6 +96,7 @@ void raw_free(const Allocator *a, void *old_ptr, isize old_size)
     args.align    = 0;
     args.old_ptr  = old_ptr;
     args.old_size = old_size;
+    args.zero     = false;
     a->procedure(a->userdata, &args);
 }
 
@@ -0,0 +1,223 @@
+#include "arena.hpp"
+
+#include <cstring>
+
+///--- REGIONS ------------------------------------------------------------ {{{1
+
+// The region header is followed by its buffer, so keep the buffer maximally
+// aligned to begin with.
+static const isize REGION_ALIGN       = align_of(std::max_align_t);
+static const isize REGION_HEADER_SIZE = (size_of(Arena_Region) + REGION_ALIGN - 1) & ~(REGION_ALIGN - 1);
+
+static byte *region_buffer(Arena_Region *region)
+{
+    return reinterpret_cast<byte *>(region) + REGION_HEADER_SIZE;
+}
+
+static Arena_Region *region_new(const Allocator &a, isize cap)
+{
+    void *memory = allocator_alloc(a, REGION_HEADER_SIZE + cap, REGION_ALIGN);
+    if (!memory) {
+        return nullptr;
+    }
+    Arena_Region *region = static_cast<Arena_Region *>(memory);
+    region->next = nullptr;
+    region->used = 0;
+    region->cap  = cap;
+    return region;
+}
+
+static void region_free(const Allocator &a, Arena_Region *region)
+{
+    allocator_free(a, region, REGION_HEADER_SIZE + region->cap);
+}
+
+/**
+ * @brief
+ *      Returns where an allocation of `size` bytes aligned to `align` would
+ *      start in `region`, or null if it does not fit.
+ */
+static byte *region_fit(Arena_Region *region, isize size, isize align)
+{
+    std::uintptr_t base    = reinterpret_cast<std::uintptr_t>(region_buffer(region));
+    std::uintptr_t start   = base + static_cast<std::uintptr_t>(region->used);
+    std::uintptr_t mask    = static_cast<std::uintptr_t>(align - 1);
+    std::uintptr_t aligned = (start + mask) & ~mask;
+    isize          offset  = static_cast<isize>(aligned - base);
+    if (offset + size > region->cap) {
+        return nullptr;
+    }
+    return reinterpret_cast<byte *>(aligned);
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- ARENA -------------------------------------------------------------- {{{1
+
+void arena_init(Arena *self, const Allocator &backing)
+{
+    arena_init(self, backing, ARENA_DEFAULT_REGION_SIZE);
+}
+
+void arena_init(Arena *self, const Allocator &backing, isize region_size)
+{
+    self->backing     = backing;
+    self->head        = nullptr;
+    self->current     = nullptr;
+    self->last        = nullptr;
+    self->region_size = region_size;
+}
+
+void arena_free(Arena *self)
+{
+    Arena_Region *region = self->head;
+    while (region) {
+        Arena_Region *next = region->next;
+        region_free(self->backing, region);
+        region = next;
+    }
+    self->head    = nullptr;
+    self->current = nullptr;
+    self->last    = nullptr;
+}
+
+void arena_free_all(Arena *self)
+{
+    // Regions past `current` are reset lazily as we move on to them.
+    self->current = self->head;
+    self->last    = nullptr;
+    if (self->current) {
+        self->current->used = 0;
+    }
+}
+
+isize arena_used(const Arena &self)
+{
+    isize total = 0;
+    for (Arena_Region *region = self.head; region; region = region->next) {
+        total += region->used;
+        if (region == self.current) {
+            break;
+        }
+    }
+    return total;
+}
+
+static void *arena_alloc(Arena *self, isize size, isize align)
+{
+    if (align < 1) {
+        align = 1;
+    }
+    assert((align & (align - 1)) == 0);
+
+    // Try the current region, then any regions kept from before the last
+    // `Free_All`, before asking the backing allocator for another.
+    byte *ptr = nullptr;
+    while (self->current) {
+        ptr = region_fit(self->current, size, align);
+        if (ptr) {
+            break;
+        }
+        Arena_Region *next = self->current->next;
+        if (!next || next->cap < size + align) {
+            break;
+        }
+        next->used    = 0;
+        self->current = next;
+    }
+
+    if (!ptr) {
+        isize cap = size + align;
+        if (cap < self->region_size) {
+            cap = self->region_size;
+        }
+        Arena_Region *region = region_new(self->backing, cap);
+        if (!region) {
+            return nullptr;
+        }
+        // Link it in right after the current region so that any regions kept
+        // from before are still reachable.
+        if (self->current) {
+            region->next        = self->current->next;
+            self->current->next = region;
+        } else {
+            region->next = self->head;
+            self->head   = region;
+        }
+        self->current = region;
+        ptr = region_fit(region, size, align);
+        assert(ptr);
+    }
+
+    self->current->used = (ptr - region_buffer(self->current)) + size;
+    self->last          = ptr;
+    return ptr;
+}
+
+/**
+ * @brief
+ *      The most recent allocation can simply move the end of its region, as
+ *      long as the region has room.
+ */
+static void *arena_resize(Arena *self, void *old_ptr, isize old_size, isize size, isize align)
+{
+    if (!old_ptr) {
+        return arena_alloc(self, size, align);
+    }
+    if (old_ptr == self->last) {
+        byte *buffer = region_buffer(self->current);
+        isize offset = static_cast<byte *>(old_ptr) - buffer;
+        if (offset + size <= self->current->cap) {
+            self->current->used = offset + size;
+            return old_ptr;
+        }
+    } else if (size <= old_size) {
+        // Anywhere else, shrinking just leaves the tail unused.
+        return old_ptr;
+    }
+    void *ptr = arena_alloc(self, size, align);
+    if (ptr) {
+        std::memcpy(ptr, old_ptr, (old_size < size) ? old_size : size);
+    }
+    return ptr;
+}
+
+static void arena_free_ptr(Arena *self, void *ptr)
+{
+    if (ptr && ptr == self->last) {
+        self->current->used = static_cast<byte *>(ptr) - region_buffer(self->current);
+        self->last          = nullptr;
+    }
+}
+
+void *arena_allocator_proc(void *allocator_data, Allocator_Mode mode, Allocator_Proc_Args args)
+{
+    Arena *self = static_cast<Arena *>(allocator_data);
+    void * ptr  = nullptr;
+    switch (mode) {
+        case Allocator_Mode::Alloc:
+            ptr = arena_alloc(self, args.size, args.align);
+            break;
+        case Allocator_Mode::Resize:
+            ptr = arena_resize(self, args.old_ptr, args.old_size, args.size, args.align);
+            break;
+        case Allocator_Mode::Free:
+            arena_free_ptr(self, args.old_ptr);
+            break;
+        case Allocator_Mode::Free_All:
+            arena_free_all(self);
+            break;
+    }
+    // `old_size` is 0 for `Alloc`, so this covers both.
+    if (ptr && args.zero && args.size > args.old_size) {
+        std::memset(static_cast<byte *>(ptr) + args.old_size, 0, args.size - args.old_size);
+    }
+    return ptr;
+}
+
+Allocator arena_allocator(Arena *self)
+{
+    return {&arena_allocator_proc, self};
+}
+
+///--- 1}}} --------------------------------------------------------------------
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "odin.hpp"
+
+/**
+ * @brief
+ *      One contiguous block of memory handed out by bumping `used`. The usable
+ *      bytes immediately follow this header.
+ */
+struct Arena_Region {
+    Arena_Region *next;
+    isize         used; // bytes handed out so far.
+    isize         cap;  // usable bytes after the header.
+};
+
+/**
+ * @brief
+ *      A linear allocator that carves allocations out of a chain of regions,
+ *      which are themselves allocated from `backing`.
+ *
+ * @note
+ *      `Free` only gives back memory if it was the most recent allocation, and
+ *      `Resize` of the most recent allocation grows or shrinks in place when
+ *      there is room. `Free_All` rewinds to the first region in O(1) while
+ *      keeping every region around for reuse. Memory is only zeroed on
+ *      request.
+ *
+ * @link
+ *      https://github.com/tsoding/arena/blob/master/arena.h
+ */
+struct Arena {
+    Allocator     backing;
+    Arena_Region *head;        // first region, where `Free_All` rewinds to.
+    Arena_Region *current;     // region we are bumping from.
+    void *        last;        // most recent allocation, or null.
+    isize         region_size; // minimum capacity of new regions.
+};
+
+#define ARENA_DEFAULT_REGION_SIZE   (1024 * 64)
+
+void arena_init(Arena *self, const Allocator &backing);
+void arena_init(Arena *self, const Allocator &backing, isize region_size);
+
+/**
+ * @brief
+ *      Returns every region to the backing allocator. Any pointers obtained
+ *      from the arena are invalid afterwards.
+ */
+void arena_free(Arena *self);
+
+/**
+ * @brief
+ *      Invalidates all allocations at once but keeps the regions, so that
+ *      e.g. per-iteration temporaries cost a pointer bump after warming up.
+ */
+void arena_free_all(Arena *self);
+
+/**
+ * @brief
+ *      Total bytes handed out across all regions so far, including padding.
+ */
+isize arena_used(const Arena &self);
+
+void *arena_allocator_proc(void *allocator_data, Allocator_Mode mode, Allocator_Proc_Args args);
+
+/**
+ * @brief
+ *      Wraps `self` for use with `Array<T>`, `String_Builder`, `BigInt` and
+ *      friends. `self` must outlive any container using it.
+ */
+Allocator arena_allocator(Arena *self);
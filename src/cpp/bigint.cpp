@@ -0,0 +1,499 @@
+#include "bigint.hpp"
+#include "bigint_internal.hpp"
+
+/**
+ * @brief
+ *      A read-only `BigInt` that views a single digit on the stack. Useful so
+ *      that the `*_digit` functions can share the general code paths.
+ *
+ * @warning
+ *      Never pass the result as a `dst` nor free it.
+ */
+static BigInt bigint_view_digit(const DIGIT *digit)
+{
+    BigInt out;
+    out.digits.allocator = {nullptr, nullptr};
+    out.digits.data      = const_cast<DIGIT *>(digit);
+    out.digits.len       = (*digit != 0) ? 1 : 0;
+    out.digits.cap       = 1;
+    out.sign             = Sign::Positive;
+    return out;
+}
+
+static Sign sign_negate(Sign sign)
+{
+    return (sign == Sign::Positive) ? Sign::Negative : Sign::Positive;
+}
+
+/**
+ * @brief
+ *      Whether `self` fits in a single digit, so that it can take the machine
+ *      word fast paths below.
+ */
+static bool bigint_is_small(const BigInt &self)
+{
+    return len(self.digits) <= 1;
+}
+
+static DIGIT bigint_small_magnitude(const BigInt &self)
+{
+    assert(bigint_is_small(self));
+    return (len(self.digits) == 0) ? 0 : self.digits[0];
+}
+
+/**
+ * @brief
+ *      Sets `dst` to `sign * (x * y)`, only spilling into a second digit if
+ *      the product needs it.
+ */
+static void bigint_set_small_product(BigInt *dst, DIGIT x, DIGIT y, Sign sign)
+{
+    DIGIT upper;
+    DIGIT lower = internal_mul_wide(x, y, &upper);
+    if (upper == 0) {
+        bigint_set_from_u64(dst, lower, sign);
+        return;
+    }
+    DIGIT *out = internal_bigint_grow(dst, 2);
+    out[0]          = lower;
+    out[1]          = upper;
+    dst->digits.len = 2;
+    dst->sign       = sign;
+}
+
+///--- INITIALIZATION ----------------------------------------------------- {{{1
+
+void bigint_init(BigInt *self, const Allocator &a)
+{
+    bigint_init(self, a, 0);
+}
+
+void bigint_init(BigInt *self, const Allocator &a, isize cap)
+{
+    array_init(&self->digits, a, 0, cap);
+    self->sign = Sign::Positive;
+}
+
+BigInt bigint_make(const Allocator &a)
+{
+    return bigint_make(a, 0);
+}
+
+BigInt bigint_make(const Allocator &a, isize cap)
+{
+    BigInt out;
+    bigint_init(&out, a, cap);
+    return out;
+}
+
+void bigint_init(BigInt *self, Pool *pool, isize cap)
+{
+    // Round up to the block we would get anyway, unless it is too big for
+    // the pool and would go to the backing allocator as is, or small enough
+    // not to need a block at all.
+    isize n_bytes = pool_class_size(size_of(DIGIT) * cap);
+    if (cap > BIGINT_INLINE_DIGITS && n_bytes > 0) {
+        cap = n_bytes / size_of(DIGIT);
+    }
+    bigint_init(self, pool_allocator(pool), cap);
+}
+
+BigInt bigint_make(Pool *pool, isize cap)
+{
+    BigInt out;
+    bigint_init(&out, pool, cap);
+    return out;
+}
+
+void bigint_free(BigInt *self)
+{
+    array_free(&self->digits);
+    self->sign = Sign::Positive;
+}
+
+void bigint_clear(BigInt *self)
+{
+    array_clear(&self->digits);
+    self->sign = Sign::Positive;
+}
+
+void bigint_reserve(BigInt *self, isize cap)
+{
+    array_reserve(&self->digits, cap);
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- "SET" FUNCTIONS ---------------------------------------------------- {{{1
+
+void bigint_set(BigInt *self, const BigInt &value)
+{
+    if (self == &value) {
+        return;
+    }
+    isize  n_len = len(value.digits);
+    DIGIT *dst   = internal_bigint_grow(self, n_len);
+    internal_copy(dst, cbegin(value.digits), n_len);
+    self->digits.len = n_len;
+    self->sign       = value.sign;
+}
+
+void bigint_set_from_u64(BigInt *self, u64 magnitude, Sign sign)
+{
+    if (magnitude == 0) {
+        bigint_clear(self);
+        return;
+    }
+    DIGIT *dst = internal_bigint_grow(self, 1);
+    dst[0]           = magnitude;
+    self->digits.len = 1;
+    self->sign       = sign;
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- PUBLIC HELPERS ----------------------------------------------------- {{{1
+
+bool bigint_is_zero(const BigInt &self)
+{
+    return len(self.digits) == 0;
+}
+
+bool bigint_is_neg(const BigInt &self)
+{
+    return self.sign == Sign::Negative;
+}
+
+isize bigint_bit_len(const BigInt &self)
+{
+    isize n_len = len(self.digits);
+    if (n_len == 0) {
+        return 0;
+    }
+    return n_len*DIGIT_BITS - internal_count_leading_zeros(self.digits[n_len - 1]);
+}
+
+void bigint_neg(BigInt *dst, const BigInt &x)
+{
+    Sign sign = sign_negate(x.sign);
+    bigint_set(dst, x);
+    if (!bigint_is_zero(*dst)) {
+        dst->sign = sign;
+    }
+}
+
+void bigint_abs(BigInt *dst, const BigInt &x)
+{
+    bigint_set(dst, x);
+    dst->sign = Sign::Positive;
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- COMPARISON --------------------------------------------------------- {{{1
+
+Comparison bigint_cmp(const BigInt &x, const BigInt &y)
+{
+    bool x_is_negative = bigint_is_neg(x);
+    /**
+     * @brief
+     *      With different signs we can assume that a negative number is always
+     *      less than a positive one.
+     */
+    if (x.sign != y.sign) {
+        return x_is_negative ? Comparison::Less : Comparison::Greater;
+    }
+    Comparison cmp = bigint_cmp_abs(x, y);
+    /**
+     * @brief
+     *      Both are negative, so the larger magnitude is the lesser value.
+     */
+    if (x_is_negative) {
+        cmp = static_cast<Comparison>(-static_cast<i8>(cmp));
+    }
+    return cmp;
+}
+
+Comparison bigint_cmp_abs(const BigInt &x, const BigInt &y)
+{
+    return internal_cmp(cbegin(x.digits), len(x.digits), cbegin(y.digits), len(y.digits));
+}
+
+Comparison bigint_cmp_digit(const BigInt &x, DIGIT y)
+{
+    // `y`, being unsigned, can never be negative.
+    if (bigint_is_neg(x)) {
+        return Comparison::Less;
+    }
+    return bigint_cmp_abs(x, bigint_view_digit(&y));
+}
+
+bool bigint_eq(const BigInt &x, const BigInt &y)
+{
+    return bigint_cmp(x, y) == Comparison::Equal;
+}
+
+bool bigint_lt(const BigInt &x, const BigInt &y)
+{
+    return bigint_cmp(x, y) == Comparison::Less;
+}
+
+bool bigint_gt(const BigInt &x, const BigInt &y)
+{
+    return bigint_cmp(x, y) == Comparison::Greater;
+}
+
+bool bigint_leq(const BigInt &x, const BigInt &y)
+{
+    return bigint_cmp(x, y) != Comparison::Greater;
+}
+
+bool bigint_geq(const BigInt &x, const BigInt &y)
+{
+    return bigint_cmp(x, y) != Comparison::Less;
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- ARITHMETIC --------------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      Sets `dst` to `(x_sign * |x|) + (y_sign * |y|)`. The signs are passed
+ *      separately so that subtraction need not copy `y` just to negate it.
+ */
+static void bigint_add_signed(BigInt *dst, const BigInt &x, Sign x_sign, const BigInt &y, Sign y_sign)
+{
+    if (bigint_is_small(x) && bigint_is_small(y)) {
+        DIGIT x_mag = bigint_small_magnitude(x);
+        DIGIT y_mag = bigint_small_magnitude(y);
+        DIGIT sum;
+        if (x_sign != y_sign) {
+            if (x_mag >= y_mag) {
+                bigint_set_from_u64(dst, x_mag - y_mag, x_sign);
+            } else {
+                bigint_set_from_u64(dst, y_mag - x_mag, y_sign);
+            }
+            return;
+        }
+        if (!internal_add_overflow(x_mag, y_mag, &sum)) {
+            bigint_set_from_u64(dst, sum, x_sign);
+            return;
+        }
+        // Carried out, so the result needs a second digit after all.
+    }
+
+    const BigInt *lhs = &x;
+    const BigInt *rhs = &y;
+    Sign          sign = x_sign;
+
+    if (x_sign == y_sign) {
+        if (len(lhs->digits) < len(rhs->digits)) {
+            lhs = &y;
+            rhs = &x;
+        }
+        isize  n_len = len(lhs->digits);
+        isize  n_rhs = len(rhs->digits);
+        // Grow first: if `dst` aliases an operand, its buffer may move.
+        DIGIT *out   = internal_bigint_grow(dst, n_len + 1);
+        out[n_len]   = internal_add(out, cbegin(lhs->digits), n_len, cbegin(rhs->digits), n_rhs);
+        dst->sign    = sign;
+        internal_bigint_trim(dst, n_len + 1);
+        return;
+    }
+
+    /**
+     * @brief
+     *      Differing signs: subtract the lesser magnitude from the greater one.
+     *      The result takes the sign of whichever had the greater magnitude.
+     */
+    switch (bigint_cmp_abs(x, y)) {
+    case Comparison::Equal:
+        bigint_clear(dst);
+        return;
+    case Comparison::Less:
+        lhs  = &y;
+        rhs  = &x;
+        sign = y_sign;
+        break;
+    case Comparison::Greater:
+        break;
+    }
+    isize  n_len = len(lhs->digits);
+    isize  n_rhs = len(rhs->digits);
+    DIGIT *out   = internal_bigint_grow(dst, n_len);
+    DIGIT  borrow = internal_sub(out, cbegin(lhs->digits), n_len, cbegin(rhs->digits), n_rhs);
+    assert(borrow == 0);
+    unused(borrow);
+    dst->sign = sign;
+    internal_bigint_trim(dst, n_len);
+}
+
+void bigint_add(BigInt *dst, const BigInt &x, const BigInt &y)
+{
+    bigint_add_signed(dst, x, x.sign, y, y.sign);
+}
+
+void bigint_add_digit(BigInt *dst, const BigInt &x, DIGIT y)
+{
+    bigint_add_signed(dst, x, x.sign, bigint_view_digit(&y), Sign::Positive);
+}
+
+void bigint_sub(BigInt *dst, const BigInt &x, const BigInt &y)
+{
+    bigint_add_signed(dst, x, x.sign, y, sign_negate(y.sign));
+}
+
+void bigint_sub_digit(BigInt *dst, const BigInt &x, DIGIT y)
+{
+    bigint_add_signed(dst, x, x.sign, bigint_view_digit(&y), Sign::Negative);
+}
+
+void bigint_mul(BigInt *dst, const BigInt &x, const BigInt &y)
+{
+    bigint_mul(dst, x, y, dst->digits.allocator);
+}
+
+void bigint_mul(BigInt *dst, const BigInt &x, const BigInt &y, const Allocator &scratch)
+{
+    isize n_x = len(x.digits);
+    isize n_y = len(y.digits);
+    if (n_x == 0 || n_y == 0) {
+        bigint_clear(dst);
+        return;
+    }
+    Sign  sign  = (x.sign == y.sign) ? Sign::Positive : Sign::Negative;
+    isize n_len = n_x + n_y;
+    if (n_x == 1 && n_y == 1) {
+        bigint_set_small_product(dst, x.digits[0], y.digits[0], sign);
+        return;
+    }
+
+    // The product is accumulated in place, so it cannot share a buffer with
+    // either operand.
+    if (dst == &x || dst == &y) {
+        BigInt tmp;
+        bigint_init(&tmp, dst->digits.allocator, n_len);
+        internal_mul(begin(tmp.digits), cbegin(x.digits), n_x, cbegin(y.digits), n_y, scratch);
+        bigint_free(dst);
+        *dst = tmp;
+    } else {
+        DIGIT *out = internal_bigint_grow(dst, n_len);
+        internal_mul(out, cbegin(x.digits), n_x, cbegin(y.digits), n_y, scratch);
+    }
+    dst->sign = sign;
+    internal_bigint_trim(dst, n_len);
+}
+
+void bigint_mul_digit(BigInt *dst, const BigInt &x, DIGIT y)
+{
+    isize n_len = len(x.digits);
+    if (n_len == 0 || y == 0) {
+        bigint_clear(dst);
+        return;
+    }
+    Sign   sign = x.sign;
+    if (n_len == 1) {
+        bigint_set_small_product(dst, x.digits[0], y, sign);
+        return;
+    }
+    DIGIT *out  = internal_bigint_grow(dst, n_len + 1);
+    out[n_len]  = internal_mul_digit(out, cbegin(x.digits), n_len, y);
+    dst->sign   = sign;
+    internal_bigint_trim(dst, n_len + 1);
+}
+
+bool bigint_divmod(BigInt *quot, BigInt *rem, const BigInt &x, const BigInt &y)
+{
+    assert(quot || rem);
+    const BigInt *some = quot ? quot : rem;
+    return bigint_divmod(quot, rem, x, y, some->digits.allocator);
+}
+
+bool bigint_divmod(BigInt *quot, BigInt *rem, const BigInt &x, const BigInt &y, const Allocator &scratch)
+{
+    assert(quot != rem || quot == nullptr);
+    isize n_x = len(x.digits);
+    isize n_y = len(y.digits);
+    if (n_y == 0) {
+        return false;
+    }
+    Sign q_sign = (x.sign == y.sign) ? Sign::Positive : Sign::Negative;
+    Sign r_sign = x.sign;
+
+    if (bigint_cmp_abs(x, y) == Comparison::Less) {
+        // Set `rem` first in case `quot` aliases `x`.
+        if (rem) {
+            bigint_set(rem, x);
+        }
+        if (quot) {
+            bigint_clear(quot);
+        }
+        return true;
+    }
+
+    // So `|y| <= |x|` fits in a digit too: no need for scratch space.
+    if (n_x == 1) {
+        DIGIT x_mag = x.digits[0];
+        DIGIT y_mag = y.digits[0];
+        if (quot) {
+            bigint_set_from_u64(quot, x_mag / y_mag, q_sign);
+        }
+        if (rem) {
+            bigint_set_from_u64(rem, x_mag % y_mag, r_sign);
+        }
+        return true;
+    }
+
+    // Divide into temporaries so that the outputs may alias the inputs.
+    isize  n_quot   = n_x - n_y + 1;
+    isize  n_buffer = n_quot + n_y;
+    DIGIT *buffer   = rawarray_new<DIGIT>(scratch, n_buffer);
+    DIGIT *q_digits = buffer;
+    DIGIT *r_digits = buffer + n_quot;
+    internal_divmod(q_digits, r_digits, cbegin(x.digits), n_x, cbegin(y.digits), n_y, scratch);
+    if (quot) {
+        DIGIT *out = internal_bigint_grow(quot, n_quot);
+        internal_copy(out, q_digits, n_quot);
+        quot->sign = q_sign;
+        internal_bigint_trim(quot, n_quot);
+    }
+    if (rem) {
+        DIGIT *out = internal_bigint_grow(rem, n_y);
+        internal_copy(out, r_digits, n_y);
+        rem->sign = r_sign;
+        internal_bigint_trim(rem, n_y);
+    }
+    rawarray_free(scratch, buffer, n_buffer);
+    return true;
+}
+
+bool bigint_div(BigInt *quot, const BigInt &x, const BigInt &y)
+{
+    return bigint_divmod(quot, nullptr, x, y);
+}
+
+bool bigint_mod(BigInt *rem, const BigInt &x, const BigInt &y)
+{
+    return bigint_divmod(nullptr, rem, x, y);
+}
+
+bool bigint_divmod_digit(BigInt *quot, DIGIT *rem, const BigInt &x, DIGIT y)
+{
+    if (y == 0) {
+        return false;
+    }
+    isize  n_len = len(x.digits);
+    Sign   sign  = x.sign;
+    // Grow first: if `quot` aliases `x`, its buffer may move.
+    DIGIT *out   = internal_bigint_grow(quot, n_len);
+    DIGIT  r     = internal_div_digit(out, cbegin(x.digits), n_len, y);
+    quot->sign   = sign;
+    internal_bigint_trim(quot, n_len);
+    if (rem) {
+        *rem = r;
+    }
+    return true;
+}
+
+///--- 1}}} --------------------------------------------------------------------
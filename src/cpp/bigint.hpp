@@ -0,0 +1,633 @@
+#pragma once
+
+#include "odin.hpp"
+#include "pool.hpp"
+#include "strings.hpp"
+
+#include <type_traits>
+
+/**
+ * @brief
+ *      Our internal representation of a single digit (a.k.a. limb). Unlike the
+ *      Odin and C implementations we use the full machine word, so each digit
+ *      is in the range `0..=DIGIT_MAX` and the base is 2^64.
+ */
+using DIGIT = u64;
+
+#define DIGIT_BITS  64
+#define DIGIT_MAX   (~static_cast<DIGIT>(0))
+
+enum class Sign : i8 {
+    Positive = 1,  // For simplicity, even 0 is considered positive.
+    Negative = -1,
+};
+
+enum class Comparison : i8 {
+    Less    = -1,
+    Equal   = 0,
+    Greater = +1,
+};
+
+enum class Parse_Error : u8 {
+    None = 0,
+    Invalid_Digit,
+    Invalid_Radix,
+};
+
+enum class Binary_Error : u8 {
+    None = 0,
+    Truncated,        // not enough bytes for the header or the limbs.
+    Invalid_Magic,
+    Invalid_Version,
+    Invalid_Limb_Width,
+    Misaligned,       // limbs cannot be viewed in place.
+};
+
+/**
+ * @brief
+ *      Number of digits a `BigInt` holds without allocating. One is enough for
+ *      anything that fits in a machine word, signed or not, which covers most
+ *      counters and indices.
+ */
+#define BIGINT_INLINE_DIGITS    1
+
+/**
+ * @brief
+ *      An arbitrary precision signed integer in sign-magnitude form.
+ *
+ * @note
+ *      `len(digits)` is the number of active digits. The magnitude is stored
+ *      in little-endian order and never has leading (most significant) zero
+ *      digits, so 0 is represented by `len(digits) == 0`.
+ *
+ *      All (re)allocations go through `digits.allocator`, but only once the
+ *      magnitude outgrows `BIGINT_INLINE_DIGITS`. Arithmetic on such small
+ *      values works on the machine words directly and only spills when the
+ *      result overflows.
+ */
+struct BigInt {
+    Small_Array<DIGIT, BIGINT_INLINE_DIGITS> digits;
+    Sign                                     sign;
+};
+
+///--- TUNING ------------------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      Digit counts (of the shorter operand) at which multiplication switches
+ *      from long multiplication to Karatsuba, and from Karatsuba to Toom-3.
+ *      Override the defaults at compile time or adjust the globals at runtime,
+ *      e.g. when benchmarking a new machine.
+ *
+ * @note
+ *      Defaults are the measured crossovers on x86-64 (g++ -O2): Karatsuba
+ *      overtakes long multiplication at ~28 digits, and Toom-3 overtakes
+ *      Karatsuba somewhere between 128 and 256 digits.
+ */
+#ifndef BIGINT_KARATSUBA_THRESHOLD
+    #define BIGINT_KARATSUBA_THRESHOLD  28
+#endif // BIGINT_KARATSUBA_THRESHOLD
+
+/**
+ * @brief
+ *      Squaring does about half the digit products in its long form, so it
+ *      stays there longer before handing over to Karatsuba.
+ */
+#ifndef BIGINT_SQR_KARATSUBA_THRESHOLD
+    #define BIGINT_SQR_KARATSUBA_THRESHOLD  48
+#endif // BIGINT_SQR_KARATSUBA_THRESHOLD
+
+#ifndef BIGINT_TOOM3_THRESHOLD
+    #define BIGINT_TOOM3_THRESHOLD      160
+#endif // BIGINT_TOOM3_THRESHOLD
+
+/**
+ * @brief
+ *      Digit count (of the shorter operand) from which we multiply via the
+ *      number-theoretic transform instead. Measured crossover with Toom-3 is
+ *      ~8000 digits (~150,000 decimal digits).
+ */
+#ifndef BIGINT_NTT_THRESHOLD
+    #define BIGINT_NTT_THRESHOLD        8000
+#endif // BIGINT_NTT_THRESHOLD
+
+/**
+ * @brief
+ *      Divisor digit count from which division recurses via Burnikel-Ziegler
+ *      (riding on the fast multiplication above) instead of Knuth D.
+ */
+#ifndef BIGINT_BURNIKEL_ZIEGLER_THRESHOLD
+    #define BIGINT_BURNIKEL_ZIEGLER_THRESHOLD   60
+#endif // BIGINT_BURNIKEL_ZIEGLER_THRESHOLD
+
+/**
+ * @brief
+ *      Digit count (of the smaller operand) from which GCDs recurse via
+ *      half-GCD, riding on the fast multiplication, instead of taking Lehmer
+ *      steps a double digit at a time. The recursion bottoms out there too.
+ *
+ * @note
+ *      Half-GCD multiplies a lot of unbalanced operands, so it only caught up
+ *      with Lehmer at around 2000 digits when measured.
+ */
+#ifndef BIGINT_HGCD_THRESHOLD
+    #define BIGINT_HGCD_THRESHOLD       2000
+#endif // BIGINT_HGCD_THRESHOLD
+
+extern isize bigint_karatsuba_threshold;
+extern isize bigint_sqr_karatsuba_threshold;
+extern isize bigint_toom3_threshold;
+extern isize bigint_ntt_threshold;
+extern isize bigint_burnikel_ziegler_threshold;
+extern isize bigint_hgcd_threshold;
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- INITIALIZATION ----------------------------------------------------- {{{1
+
+void   bigint_init(BigInt *self, const Allocator &a);
+void   bigint_init(BigInt *self, const Allocator &a, isize cap);
+BigInt bigint_make(const Allocator &a);
+BigInt bigint_make(const Allocator &a, isize cap);
+void   bigint_free(BigInt *self);
+
+/**
+ * @brief
+ *      Like the above but with room for at least `cap` digits taken straight
+ *      from one of `pool`'s size classes. The whole block counts as capacity,
+ *      so later growth within the class costs nothing, and `bigint_free`
+ *      hands the block back to the same class for the next intermediate.
+ *
+ * @note
+ *      Only `pool`'s owner thread may grow `self`, though any thread may free
+ *      it. BigInts that move between worker threads should use
+ *      `cache_allocator` instead, which has the same size classes.
+ */
+void   bigint_init(BigInt *self, Pool *pool, isize cap);
+BigInt bigint_make(Pool *pool, isize cap);
+
+/**
+ * @brief
+ *      Sets `self` to 0 but does not deallocate its digits.
+ */
+void bigint_clear(BigInt *self);
+
+/**
+ * @brief
+ *      Ensures `self` can hold at least `cap` digits without reallocating.
+ */
+void bigint_reserve(BigInt *self, isize cap);
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- "SET" FUNCTIONS ---------------------------------------------------- {{{1
+
+void bigint_set(BigInt *self, const BigInt &value);
+void bigint_set_from_u64(BigInt *self, u64 magnitude, Sign sign);
+
+/**
+ * @brief
+ *      Accepts any builtin integer type. Maximally negative values are handled
+ *      by negating in the unsigned domain.
+ */
+template<class T>
+void bigint_set_from_integer(BigInt *self, T value)
+{
+    static_assert(std::is_integral<T>::value, "T must be an integer type");
+    static_assert(sizeof(T) <= sizeof(u64), "T must fit in a u64");
+    if constexpr (std::is_signed<T>::value) {
+        u64 magnitude = static_cast<u64>(value);
+        if (value < 0) {
+            magnitude = 0 - magnitude;
+        }
+        bigint_set_from_u64(self, magnitude, (value < 0) ? Sign::Negative : Sign::Positive);
+    } else {
+        bigint_set_from_u64(self, static_cast<u64>(value), Sign::Positive);
+    }
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- PUBLIC HELPERS ----------------------------------------------------- {{{1
+
+bool bigint_is_zero(const BigInt &self);
+bool bigint_is_neg(const BigInt &self);
+
+/**
+ * @brief
+ *      Number of bits in `|self|`, i.e. the position of the highest set bit
+ *      plus one. 0 has no bits.
+ */
+isize bigint_bit_len(const BigInt &self);
+
+/**
+ * @brief
+ *      Sets `dst` to `-x`. `dst` may alias `x`.
+ */
+void bigint_neg(BigInt *dst, const BigInt &x);
+
+/**
+ * @brief
+ *      Sets `dst` to `|x|`. `dst` may alias `x`.
+ */
+void bigint_abs(BigInt *dst, const BigInt &x);
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- COMPARISON --------------------------------------------------------- {{{1
+
+Comparison bigint_cmp(const BigInt &x, const BigInt &y);
+Comparison bigint_cmp_abs(const BigInt &x, const BigInt &y);
+Comparison bigint_cmp_digit(const BigInt &x, DIGIT y);
+
+bool bigint_eq(const BigInt &x, const BigInt &y);
+bool bigint_lt(const BigInt &x, const BigInt &y);
+bool bigint_gt(const BigInt &x, const BigInt &y);
+bool bigint_leq(const BigInt &x, const BigInt &y);
+bool bigint_geq(const BigInt &x, const BigInt &y);
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- ARITHMETIC --------------------------------------------------------- {{{1
+
+/**
+ * @note
+ *      For all arithmetic functions, `dst` may alias any of the operands.
+ */
+
+void bigint_add(BigInt *dst, const BigInt &x, const BigInt &y);
+void bigint_add_digit(BigInt *dst, const BigInt &x, DIGIT y);
+void bigint_sub(BigInt *dst, const BigInt &x, const BigInt &y);
+void bigint_sub_digit(BigInt *dst, const BigInt &x, DIGIT y);
+void bigint_mul(BigInt *dst, const BigInt &x, const BigInt &y);
+
+/**
+ * @brief
+ *      Like the above, but temporaries for the subquadratic algorithms are
+ *      taken from `scratch` instead of `dst`'s allocator. Each call makes at
+ *      most one scratch allocation no matter how deep the recursion goes.
+ */
+void bigint_mul(BigInt *dst, const BigInt &x, const BigInt &y, const Allocator &scratch);
+void bigint_mul_digit(BigInt *dst, const BigInt &x, DIGIT y);
+
+/**
+ * @brief
+ *      Truncating division: `quot = x / y` rounded toward zero and
+ *      `rem = x - quot * y`, so `rem` takes the sign of `x`. Either output may
+ *      be null, but they may not be the same `BigInt`.
+ *
+ * @return
+ *      false if `y` is 0, in which case neither output is touched.
+ */
+bool bigint_divmod(BigInt *quot, BigInt *rem, const BigInt &x, const BigInt &y);
+
+/**
+ * @brief
+ *      Like the above, but temporaries are taken from `scratch`.
+ */
+bool bigint_divmod(BigInt *quot, BigInt *rem, const BigInt &x, const BigInt &y, const Allocator &scratch);
+bool bigint_div(BigInt *quot, const BigInt &x, const BigInt &y);
+bool bigint_mod(BigInt *rem, const BigInt &x, const BigInt &y);
+
+/**
+ * @brief
+ *      Sets `quot` to `x / y` rounded toward zero and `*rem` to `|x| % y`.
+ *      `rem` may be null.
+ */
+bool bigint_divmod_digit(BigInt *quot, DIGIT *rem, const BigInt &x, DIGIT y);
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- MODULAR ARITHMETIC ------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      What Montgomery multiplication modulo an odd `m` of `len` digits needs,
+ *      worked out once and then shared by any number of calls (or threads,
+ *      since it is read-only afterwards).
+ *
+ * @note
+ *      With `R = 2^(64 * len)`, a residue `x` is kept as `x * R mod m` (its
+ *      Montgomery form). A product in that form costs a multiplication and a
+ *      reduction by `R`, which is just shifting digits out, instead of a
+ *      division by `m`.
+ */
+struct Montgomery {
+    Allocator allocator; // owns `modulus` and `r2`.
+    DIGIT *   modulus;   // `m`, odd.
+    DIGIT *   r2;        // `R^2 mod m`, which converts into Montgomery form.
+    DIGIT     inv;       // `-1 / m mod 2^64`.
+    isize     len;       // digits in `m` and in every residue.
+};
+
+/**
+ * @return
+ *      false if `modulus` is even (or 0), which Montgomery reduction cannot
+ *      handle. The sign of `modulus` is ignored.
+ */
+bool montgomery_init(Montgomery *self, const BigInt &modulus, const Allocator &a);
+void montgomery_free(Montgomery *self);
+
+/**
+ * @brief
+ *      Sets `dst` to the Montgomery form of `x`, which may be any integer, and
+ *      back. The result is always in `0..<m`.
+ */
+void montgomery_to(const Montgomery &self, BigInt *dst, const BigInt &x);
+void montgomery_to(const Montgomery &self, BigInt *dst, const BigInt &x, const Allocator &scratch);
+void montgomery_from(const Montgomery &self, BigInt *dst, const BigInt &x);
+void montgomery_from(const Montgomery &self, BigInt *dst, const BigInt &x, const Allocator &scratch);
+
+/**
+ * @brief
+ *      Sets `dst` to the Montgomery form of `x * y` (or `x * x`) given those of
+ *      `x` and `y`, which must already be in `0..<m`. `dst` may alias either.
+ */
+void montgomery_mul(const Montgomery &self, BigInt *dst, const BigInt &x, const BigInt &y);
+void montgomery_mul(const Montgomery &self, BigInt *dst, const BigInt &x, const BigInt &y, const Allocator &scratch);
+void montgomery_sqr(const Montgomery &self, BigInt *dst, const BigInt &x);
+void montgomery_sqr(const Montgomery &self, BigInt *dst, const BigInt &x, const Allocator &scratch);
+
+/**
+ * @brief
+ *      Sets `dst` to `base^exp mod m`, in `0..<m`, using sliding windows over
+ *      the bits of `exp`. `dst` may alias `base` or `exp`.
+ *
+ * @note
+ *      All temporaries (the window table, the accumulator and the product
+ *      buffer) come from a single allocation from `scratch`, plus one for a
+ *      division if `base` has more digits than `m`. With an `Arena` as
+ *      `scratch`, repeated calls stop touching the heap entirely.
+ *
+ * @return
+ *      false if `exp` is negative, in which case `dst` is not touched.
+ */
+bool bigint_modpow(BigInt *dst, const BigInt &base, const BigInt &exp, const Montgomery &ctx);
+bool bigint_modpow(BigInt *dst, const BigInt &base, const BigInt &exp, const Montgomery &ctx,
+    const Allocator &scratch);
+
+/**
+ * @brief
+ *      Like the above, but sets up a `Montgomery` for `modulus` just for this
+ *      call. Even moduli fall back to dividing after every step.
+ *
+ * @return
+ *      false if `modulus` is 0 or `exp` is negative.
+ */
+bool bigint_modpow(BigInt *dst, const BigInt &base, const BigInt &exp, const BigInt &modulus);
+bool bigint_modpow(BigInt *dst, const BigInt &base, const BigInt &exp, const BigInt &modulus,
+    const Allocator &scratch);
+
+/**
+ * @brief
+ *      Sets each `dst[i]` to `bases[i]^exps[i] mod m`. The three slices must
+ *      be the same length, and `dst[i]` may alias `bases[i]` or `exps[i]`.
+ *
+ * @note
+ *      The bases are converted into one contiguous block of residues, which
+ *      up to `thread_count` threads (the caller included) then exponentiate
+ *      in place without allocating. `scratch` is only used from the calling
+ *      thread, as is every `dst[i]`, so pool-backed `BigInt`s are fine. Batches
+ *      too small to be worth a thread run entirely on the caller. The short
+ *      forms use all hardware threads and `heap_allocator`.
+ *
+ * @return
+ *      false if any exponent is negative (or `modulus` is 0), in which case
+ *      `dst` is not touched.
+ *
+ * @warning
+ *      With an even `modulus`, which Montgomery reduction cannot handle, the
+ *      batch is simply done one `bigint_modpow` at a time on this thread.
+ */
+bool bigint_modpow_batch(Slice<BigInt> dst, const Slice<BigInt> &bases, const Slice<BigInt> &exps,
+    const Montgomery &ctx);
+bool bigint_modpow_batch(Slice<BigInt> dst, const Slice<BigInt> &bases, const Slice<BigInt> &exps,
+    const Montgomery &ctx, isize thread_count, const Allocator &scratch);
+bool bigint_modpow_batch(Slice<BigInt> dst, const Slice<BigInt> &bases, const Slice<BigInt> &exps,
+    const BigInt &modulus);
+bool bigint_modpow_batch(Slice<BigInt> dst, const Slice<BigInt> &bases, const Slice<BigInt> &exps,
+    const BigInt &modulus, isize thread_count, const Allocator &scratch);
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- NUMBER THEORY ------------------------------------------------------ {{{1
+
+/**
+ * @brief
+ *      Sets `dst` to the greatest common divisor of `x` and `y`, which is
+ *      never negative. `gcd(0, 0)` is 0. `dst` may alias either operand.
+ *
+ * @note
+ *      Operands of up to two digits take binary GCD on machine words without
+ *      allocating. Temporaries otherwise come from `scratch`, or `dst`'s
+ *      allocator.
+ */
+void bigint_gcd(BigInt *dst, const BigInt &x, const BigInt &y);
+void bigint_gcd(BigInt *dst, const BigInt &x, const BigInt &y, const Allocator &scratch);
+
+/**
+ * @brief
+ *      Sets `dst` to the least common multiple of `x` and `y`, which is never
+ *      negative, and 0 if either is.
+ */
+void bigint_lcm(BigInt *dst, const BigInt &x, const BigInt &y);
+void bigint_lcm(BigInt *dst, const BigInt &x, const BigInt &y, const Allocator &scratch);
+
+/**
+ * @brief
+ *      Extended Euclid: sets `gcd` as above, and `s` and `t` such that
+ *      `gcd = s*x + t*y`, with `|s| <= |y| / gcd` and `|t| <= |x| / gcd`. Any
+ *      output may be null, and any may alias `x` or `y`.
+ *
+ * @note
+ *      Only `s` is tracked along the way. `t` costs one more division at
+ *      the end, so leave it null if you can.
+ */
+void bigint_gcd_ext(BigInt *gcd, BigInt *s, BigInt *t, const BigInt &x, const BigInt &y);
+void bigint_gcd_ext(BigInt *gcd, BigInt *s, BigInt *t, const BigInt &x, const BigInt &y,
+    const Allocator &scratch);
+
+/**
+ * @brief
+ *      Sets `dst` to the inverse of `x` modulo `|modulus|`, in
+ *      `0..<|modulus|`.
+ *
+ * @return
+ *      false if there is none, i.e. `x` and `modulus` share a factor or
+ *      `modulus` is 0, in which case `dst` is not touched.
+ */
+bool bigint_mod_inverse(BigInt *dst, const BigInt &x, const BigInt &modulus);
+bool bigint_mod_inverse(BigInt *dst, const BigInt &x, const BigInt &modulus, const Allocator &scratch);
+
+/**
+ * @brief
+ *      Sets `dst` to `floor(sqrt(x))`. `dst` may alias `x`.
+ *
+ * @note
+ *      Newton's method with the precision doubling each round, so it costs
+ *      about as much as a couple of divisions of `x`'s size.
+ *
+ * @return
+ *      false if `x` is negative, in which case `dst` is not touched.
+ */
+bool bigint_isqrt(BigInt *dst, const BigInt &x);
+bool bigint_isqrt(BigInt *dst, const BigInt &x, const Allocator &scratch);
+
+/**
+ * @brief
+ *      Sets `dst` to the `n`th root of `x`, rounded toward zero. `dst` may
+ *      alias `x`.
+ *
+ * @return
+ *      false if `n <= 0`, or `n` is even and `x` negative, in which case
+ *      `dst` is not touched.
+ */
+bool bigint_iroot(BigInt *dst, const BigInt &x, isize n);
+bool bigint_iroot(BigInt *dst, const BigInt &x, isize n, const Allocator &scratch);
+
+/**
+ * @brief
+ *      Whether `x = r^2` for some integer `r`. Most non-squares are turned
+ *      away by their residues without taking a root.
+ */
+bool bigint_is_square(const BigInt &x);
+bool bigint_is_square(const BigInt &x, const Allocator &scratch);
+
+/**
+ * @brief
+ *      Whether `x = r^n` for some integers `r` and `n >= 2`. 0, 1 and -1 are.
+ */
+bool bigint_is_perfect_power(const BigInt &x);
+bool bigint_is_perfect_power(const BigInt &x, const Allocator &scratch);
+
+/**
+ * @brief
+ *      Sets `dst` to `n!`.
+ *
+ * @note
+ *      Works from the prime factorization, multiplying out the primes by
+ *      balanced product trees split between up to `thread_count` threads
+ *      (the caller included). `scratch` is only used from the calling thread;
+ *      the others allocate from `heap_allocator`. The short forms use all
+ *      hardware threads and `dst`'s allocator.
+ *
+ * @return
+ *      false if `n` is negative, in which case `dst` is not touched.
+ */
+bool bigint_factorial(BigInt *dst, isize n);
+bool bigint_factorial(BigInt *dst, isize n, isize thread_count, const Allocator &scratch);
+
+/**
+ * @brief
+ *      Sets `dst` to the binomial coefficient `C(n, k)`, which is 0 for `k < 0`
+ *      or `k > n >= 0`. Negative `n` follow `C(n, k) = (-1)^k C(k - n - 1, k)`.
+ *      Threads and `scratch` are as for `bigint_factorial`.
+ */
+void bigint_binomial(BigInt *dst, isize n, isize k);
+void bigint_binomial(BigInt *dst, isize n, isize k, isize thread_count, const Allocator &scratch);
+
+/**
+ * @brief
+ *      Sets `dst` to the product of all primes up to `n`, which is 1 for
+ *      `n < 2`. Threads and `scratch` are as for `bigint_factorial`.
+ */
+void bigint_primorial(BigInt *dst, isize n);
+void bigint_primorial(BigInt *dst, isize n, isize thread_count, const Allocator &scratch);
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- STRING CONVERSION -------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      Appends the decimal representation of `self` to `bd`, with a leading
+ *      `-` if negative. Large numbers are converted by divide-and-conquer in
+ *      roughly the time of a few multiplications of the same size.
+ */
+void bigint_to_string(String_Builder *bd, const BigInt &self);
+
+/**
+ * @brief
+ *      Like the above, but the power tree and other temporaries are taken from
+ *      `scratch` instead of `bd`'s allocator.
+ */
+void bigint_to_string(String_Builder *bd, const BigInt &self, const Allocator &scratch);
+
+/**
+ * @brief
+ *      Parses `input` in the given `radix` (2, 8, 10 or 16) into `self`.
+ *      Leading signs and whitespace are skipped, each `-` flipping the sign,
+ *      as is trailing junk. Digits may be separated by `_`, `,` or spaces.
+ *      A `radix` of 0 detects a `0b`, `0o`, `0d` or `0x` prefix, defaulting to
+ *      base 10.
+ *
+ * @note
+ *      On error `self` is left untouched. Large decimal inputs are combined
+ *      by a balanced product tree, so parsing costs a few multiplications of
+ *      the same size rather than one pass over the whole number per digit.
+ */
+Parse_Error bigint_set_from_string(BigInt *self, const String &input);
+Parse_Error bigint_set_from_string(BigInt *self, const String &input, int radix);
+Parse_Error bigint_set_from_string(BigInt *self, const String &input, int radix, const Allocator &scratch);
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- BINARY SERIALIZATION ----------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      Layout of one serialized number, all little-endian:
+ *
+ *          offset  size  field
+ *          0       4     magic "BGNT"
+ *          4       2     version (1)
+ *          6       1     limb width in bytes (8, or 4 from 32-bit producers)
+ *          7       1     sign (0 positive, 1 negative)
+ *          8       8     limb count
+ *          16      ...   limbs, least significant first
+ *
+ *      The header is 16 bytes so that limbs stay 8-byte aligned in a mapped
+ *      file, and records may simply be concatenated.
+ */
+#define BIGINT_BINARY_VERSION       1
+#define BIGINT_BINARY_HEADER_SIZE   16
+
+/**
+ * @brief
+ *      Number of bytes `bigint_write_binary` produces for `self`.
+ */
+isize bigint_binary_size(const BigInt &self);
+
+void bigint_write_binary(String_Builder *bd, const BigInt &self);
+
+/**
+ * @brief
+ *      Streams `self` to `fd`. On little-endian machines the limbs are written
+ *      straight from `self`, without an intermediate copy.
+ *
+ * @return
+ *      false if writing failed.
+ */
+bool bigint_write_binary(int fd, const BigInt &self);
+
+/**
+ * @brief
+ *      Reads one number from the front of `*data` into `self` and advances
+ *      `*data` past it. On error neither is touched.
+ */
+Binary_Error bigint_set_from_binary(BigInt *self, String *data);
+
+/**
+ * @brief
+ *      Like the above, but points `self` straight at the limbs in `*data` (e.g.
+ *      a `Mapped_File`) instead of copying them, so it costs the same however
+ *      big the number is.
+ *
+ * @warning
+ *      The result is read-only: it may be used as an operand, but not as a
+ *      destination, and must not outlive `*data`. Freeing it is a no-op. Only
+ *      8-byte limbs on little-endian machines, 8-byte aligned, can be viewed.
+ */
+Binary_Error bigint_view_binary(BigInt *self, String *data);
+
+///--- 1}}} --------------------------------------------------------------------
@@ -0,0 +1,226 @@
+#include "bigint.hpp"
+#include "bigint_internal.hpp"
+#include "io.hpp"
+
+#include <cstring>
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    #define BIGINT_BIG_ENDIAN
+#endif
+
+static const char BINARY_MAGIC[4] = {'B', 'G', 'N', 'T'};
+
+///--- HEADER ------------------------------------------------------------- {{{1
+
+struct Binary_Header {
+    isize limb_count;
+    int   limb_width;
+    Sign  sign;
+};
+
+static void store_le(byte *dst, u64 value, isize size)
+{
+    for (isize i = 0; i < size; i++) {
+        dst[i] = static_cast<byte>(value >> (8 * i));
+    }
+}
+
+static u64 load_le(const byte *src, isize size)
+{
+    u64 value = 0;
+    for (isize i = 0; i < size; i++) {
+        value |= static_cast<u64>(src[i]) << (8 * i);
+    }
+    return value;
+}
+
+static void header_encode(byte (&dst)[BIGINT_BINARY_HEADER_SIZE], const BigInt &self)
+{
+    std::memcpy(dst, BINARY_MAGIC, size_of(BINARY_MAGIC));
+    store_le(dst + 4, BIGINT_BINARY_VERSION, 2);
+    dst[6] = size_of(DIGIT);
+    dst[7] = (self.sign == Sign::Negative) ? 1 : 0;
+    store_le(dst + 8, static_cast<u64>(len(self.digits)), 8);
+}
+
+/**
+ * @brief
+ *      Checks the header at the front of `data`, including that all the limbs
+ *      it announces are there.
+ */
+static Binary_Error header_decode(Binary_Header *header, const String &data)
+{
+    if (len(data) < BIGINT_BINARY_HEADER_SIZE) {
+        return Binary_Error::Truncated;
+    }
+    const byte *src = reinterpret_cast<const byte *>(begin(data));
+    if (std::memcmp(src, BINARY_MAGIC, size_of(BINARY_MAGIC)) != 0) {
+        return Binary_Error::Invalid_Magic;
+    }
+    if (load_le(src + 4, 2) != BIGINT_BINARY_VERSION) {
+        return Binary_Error::Invalid_Version;
+    }
+    int limb_width = src[6];
+    if (limb_width != 4 && limb_width != 8) {
+        return Binary_Error::Invalid_Limb_Width;
+    }
+    u64 limb_count = load_le(src + 8, 8);
+    u64 available  = static_cast<u64>(len(data) - BIGINT_BINARY_HEADER_SIZE) / limb_width;
+    if (limb_count > available) {
+        return Binary_Error::Truncated;
+    }
+    header->limb_count = static_cast<isize>(limb_count);
+    header->limb_width = limb_width;
+    header->sign       = (src[7] != 0) ? Sign::Negative : Sign::Positive;
+    return Binary_Error::None;
+}
+
+static isize record_size(const Binary_Header &header)
+{
+    return BIGINT_BINARY_HEADER_SIZE + header.limb_count * header.limb_width;
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- WRITING ------------------------------------------------------------ {{{1
+
+isize bigint_binary_size(const BigInt &self)
+{
+    return BIGINT_BINARY_HEADER_SIZE + size_of(DIGIT) * len(self.digits);
+}
+
+void bigint_write_binary(String_Builder *bd, const BigInt &self)
+{
+    byte header[BIGINT_BINARY_HEADER_SIZE];
+    header_encode(header, self);
+
+    // Every byte gets written below, so no need to zero them first.
+    // Grow like any other append, so writing records back to back stays linear.
+    isize start  = string_builder_len(*bd);
+    isize needed = start + bigint_binary_size(self);
+    if (needed > cap(bd->buffer)) {
+        array_reserve(&bd->buffer, array_grow_cap(cap(bd->buffer), needed));
+    }
+    bd->buffer.len = needed;
+    byte *dst = reinterpret_cast<byte *>(begin(bd->buffer) + start);
+    std::memcpy(dst, header, size_of(header));
+    dst += size_of(header);
+    for (isize i = 0; i < len(self.digits); i++) {
+        store_le(dst + size_of(DIGIT) * i, self.digits[i], size_of(DIGIT));
+    }
+}
+
+bool bigint_write_binary(int fd, const BigInt &self)
+{
+    byte header[BIGINT_BINARY_HEADER_SIZE];
+    header_encode(header, self);
+    if (io_write(fd, header, size_of(header)) != size_of(header)) {
+        return false;
+    }
+
+#if defined(BIGINT_BIG_ENDIAN)
+    // Byte swap a block at a time.
+    byte  block[4096];
+    isize per_block = size_of(block) / size_of(DIGIT);
+    for (isize i = 0; i < len(self.digits); i += per_block) {
+        isize count = len(self.digits) - i;
+        if (count > per_block) {
+            count = per_block;
+        }
+        for (isize j = 0; j < count; j++) {
+            store_le(block + size_of(DIGIT) * j, self.digits[i + j], size_of(DIGIT));
+        }
+        isize size = size_of(DIGIT) * count;
+        if (io_write(fd, block, size) != size) {
+            return false;
+        }
+    }
+    return true;
+#else
+    isize size = size_of(DIGIT) * len(self.digits);
+    return io_write(fd, cbegin(self.digits), size) == size;
+#endif
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- READING ------------------------------------------------------------ {{{1
+
+Binary_Error bigint_set_from_binary(BigInt *self, String *data)
+{
+    Binary_Header header;
+    Binary_Error  error = header_decode(&header, *data);
+    if (error != Binary_Error::None) {
+        return error;
+    }
+
+    // Two 32-bit limbs make one of our digits.
+    const byte *src    = reinterpret_cast<const byte *>(begin(*data)) + BIGINT_BINARY_HEADER_SIZE;
+    isize       n_src  = header.limb_count;
+    isize       n_len  = (header.limb_width == 8) ? n_src : (n_src + 1) / 2;
+    DIGIT *     digits = internal_bigint_grow(self, n_len);
+    if (header.limb_width == 8) {
+        for (isize i = 0; i < n_len; i++) {
+            digits[i] = load_le(src + 8 * i, 8);
+        }
+    } else {
+        for (isize i = 0; i < n_len; i++) {
+            DIGIT lower = load_le(src + 8 * i, 4);
+            DIGIT upper = (2 * i + 1 < n_src) ? load_le(src + 8 * i + 4, 4) : 0;
+            digits[i]   = lower | (upper << 32);
+        }
+    }
+    self->sign = header.sign;
+    internal_bigint_trim(self, n_len);
+    *data = slice(*data, record_size(header), len(*data));
+    return Binary_Error::None;
+}
+
+/**
+ * @brief
+ *      Views do not own their digits, so there is nothing to free, and growing
+ *      them is a bug.
+ */
+static void *view_allocator_proc(void *allocator_data, Allocator_Mode mode, Allocator_Proc_Args args)
+{
+    unused(allocator_data);
+    unused(args);
+    assert(mode == Allocator_Mode::Free || mode == Allocator_Mode::Free_All);
+    unused(mode);
+    return nullptr;
+}
+
+Binary_Error bigint_view_binary(BigInt *self, String *data)
+{
+    Binary_Header header;
+    Binary_Error  error = header_decode(&header, *data);
+    if (error != Binary_Error::None) {
+        return error;
+    }
+    if (header.limb_width != size_of(DIGIT)) {
+        return Binary_Error::Invalid_Limb_Width;
+    }
+
+    const char *limbs = begin(*data) + BIGINT_BINARY_HEADER_SIZE;
+#if defined(BIGINT_BIG_ENDIAN)
+    unused(limbs);
+    return Binary_Error::Misaligned;
+#else
+    if (reinterpret_cast<std::uintptr_t>(limbs) % align_of(DIGIT) != 0) {
+        return Binary_Error::Misaligned;
+    }
+    // The digits are never written through, whatever the type says.
+    DIGIT *digits = const_cast<DIGIT *>(reinterpret_cast<const DIGIT *>(limbs));
+    isize  n_len  = internal_normalize(digits, header.limb_count);
+
+    self->digits.allocator = {&view_allocator_proc, nullptr};
+    self->digits.data      = digits;
+    self->digits.len       = n_len;
+    self->digits.cap       = n_len;
+    self->sign             = (n_len > 0) ? header.sign : Sign::Positive;
+    *data = slice(*data, record_size(header), len(*data));
+    return Binary_Error::None;
+#endif
+}
+
+///--- 1}}} --------------------------------------------------------------------
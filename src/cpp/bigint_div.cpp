@@ -0,0 +1,461 @@
+#include "bigint_internal.hpp"
+
+/**
+ * @brief
+ *      Division kernels on raw digit buffers.
+ *
+ * @note
+ *      `internal_divmod_basecase` is the quadratic workhorse. Large one-off
+ *      divisions go through Burnikel-Ziegler, which splits them into
+ *      multiplications. For divisors that are reused many times we instead
+ *      precompute a reciprocal once, after which each division costs two
+ *      multiplications.
+ */
+
+isize bigint_burnikel_ziegler_threshold = BIGINT_BURNIKEL_ZIEGLER_THRESHOLD;
+
+// Below this many digits, Newton's iteration costs more than long division.
+static const isize RECIPROCAL_BASECASE = 32;
+
+///--- LONG DIVISION ------------------------------------------------------ {{{1
+
+DIGIT internal_div_digit(DIGIT *quot, const DIGIT *x, isize len, DIGIT y)
+{
+    assert(y != 0);
+    DIGIT rem = 0;
+    for (isize i = len - 1; i >= 0; i--) {
+        quot[i] = internal_div_wide(rem, x[i], y, &rem);
+    }
+    return rem;
+}
+
+DIGIT internal_mod_digit(const DIGIT *x, isize len, DIGIT y)
+{
+    assert(y != 0);
+    DIGIT rem = 0;
+    for (isize i = len - 1; i >= 0; i--) {
+        internal_div_wide(rem, x[i], y, &rem);
+    }
+    return rem;
+}
+
+/**
+ * @link
+ *      The Art of Computer Programming, Vol. 2, Section 4.3.1, Algorithm D.
+ */
+void internal_divmod_basecase(DIGIT *quot, DIGIT *rem, const DIGIT *x, isize x_len,
+    const DIGIT *y, isize y_len, DIGIT *scratch)
+{
+    assert(x_len >= y_len && y_len > 0);
+    assert(y[y_len - 1] != 0);
+    if (y_len == 1) {
+        DIGIT r = internal_div_digit(quot, x, x_len, y[0]);
+        if (rem) {
+            rem[0] = r;
+        }
+        return;
+    }
+
+    // D1: Shift both so the divisor's top bit is set, which keeps each
+    // quotient digit estimate within 2 of the real thing.
+    int    shift = internal_count_leading_zeros(y[y_len - 1]);
+    DIGIT *yn    = scratch;
+    DIGIT *xn    = scratch + y_len;
+    internal_shl(yn, y, y_len, shift);
+    xn[x_len] = internal_shl(xn, x, x_len, shift);
+
+    DIGIT y_top  = yn[y_len - 1];
+    DIGIT y_next = yn[y_len - 2];
+    for (isize j = x_len - y_len; j >= 0; j--) {
+        // D3: Estimate from the top two digits of the running remainder, then
+        // refine against the third. The remainder is always less than
+        // `yn * B`, so `x_top` can at most equal `y_top`.
+        DIGIT x_top = xn[j + y_len];
+        DIGIT x_mid = xn[j + y_len - 1];
+        DIGIT qhat;
+        DIGIT rhat;
+        bool  rhat_overflow;
+        if (x_top == y_top) {
+            qhat          = DIGIT_MAX;
+            rhat          = x_mid + y_top;
+            rhat_overflow = (rhat < x_mid);
+        } else {
+            qhat          = internal_div_wide(x_top, x_mid, y_top, &rhat);
+            rhat_overflow = false;
+        }
+        while (!rhat_overflow) {
+            DIGIT upper;
+            DIGIT lower = internal_mul_wide(qhat, y_next, &upper);
+            if (upper < rhat || (upper == rhat && lower <= xn[j + y_len - 2])) {
+                break;
+            }
+            qhat--;
+            rhat         += y_top;
+            rhat_overflow = (rhat < y_top);
+        }
+
+        // D4-D6: Multiply and subtract. Rarely the estimate is still one too
+        // large, which shows up as a borrow out of the top digit.
+        DIGIT borrow  = internal_mul_sub_digit(xn + j, yn, y_len, qhat);
+        DIGIT top     = xn[j + y_len];
+        xn[j + y_len] = top - borrow;
+        if (top < borrow) {
+            qhat--;
+            xn[j + y_len] += internal_add(xn + j, xn + j, yn, y_len);
+        }
+        quot[j] = qhat;
+    }
+
+    // D8: Unnormalize.
+    if (rem) {
+        internal_shr(rem, xn, y_len, shift);
+    }
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- RECIPROCALS -------------------------------------------------------- {{{1
+
+static void reciprocal_basecase(DIGIT *inv, const DIGIT *d, isize n, const Allocator &scratch)
+{
+    // B^(2n) has 2n + 1 digits; the quotient has n + 2.
+    isize  n_num    = 2*n + 1;
+    isize  n_buffer = n_num + (n_num + n + 1);
+    DIGIT *num      = rawarray_new<DIGIT>(scratch, n_buffer);
+    internal_zero(num, n_num - 1);
+    num[n_num - 1] = 1;
+    internal_divmod_basecase(inv, nullptr, num, n_num, d, n, num + n_num);
+    rawarray_free(scratch, num, n_buffer);
+}
+
+/**
+ * @brief
+ *      The reciprocal of the top `h` digits of `d`, scaled up by `B^(n - h)`,
+ *      is within a relative error of `B^-(h - 1)`. One Newton step
+ *      `v += v * (B^(2n) - d*v) / B^(2n)` squares that error; with
+ *      `h = n/2 + 2` that leaves us a couple of units off, which the final
+ *      correction loop fixes exactly.
+ */
+void internal_reciprocal(DIGIT *inv, const DIGIT *d, isize n, const Allocator &scratch)
+{
+    assert(n > 0 && d[n - 1] != 0);
+    if (n <= RECIPROCAL_BASECASE) {
+        reciprocal_basecase(inv, d, n, scratch);
+        return;
+    }
+
+    isize h     = n/2 + 2;
+    isize shift = n - h;
+
+    // `prod` holds `d * v` (2n + 2 digits) and `power` holds `B^(2n)`. `err`
+    // and `corr` are large enough for `|B^(2n) - d*v|` and its product with
+    // the half-length reciprocal.
+    isize n_wide   = 2*n + 2;
+    isize n_buffer = (h + 2) + 3*n_wide + (n_wide + h + 2);
+    DIGIT *buffer  = rawarray_new<DIGIT>(scratch, n_buffer);
+    DIGIT *half    = buffer;
+    DIGIT *prod    = half + (h + 2);
+    DIGIT *power   = prod + n_wide;
+    DIGIT *err     = power + n_wide;
+    DIGIT *corr    = err + n_wide;
+
+    internal_reciprocal(half, d + shift, h, scratch);
+    isize n_half = internal_normalize(half, h + 2);
+
+    internal_zero(power, n_wide);
+    power[2*n] = 1;
+
+    // v = half * B^shift, so d*v is just d*half shifted up.
+    internal_zero(prod, shift);
+    internal_mul(prod + shift, d, n, half, n_half, scratch);
+    internal_zero(prod + shift + n + n_half, n_wide - (shift + n + n_half));
+
+    // err = |B^(2n) - d*v|. The initial estimate is usually a bit too large.
+    bool too_large = (internal_cmp(prod, power, n_wide) == Comparison::Greater);
+    if (too_large) {
+        internal_sub(err, prod, power, n_wide);
+    } else {
+        internal_sub(err, power, prod, n_wide);
+    }
+    isize n_err = internal_normalize(err, n_wide);
+
+    // correction = v * err / B^(2n) = half * err / B^(n + h)
+    internal_zero(inv, n + 2);
+    internal_copy(inv + shift, half, n_half);
+    if (n_err > 0) {
+        isize n_corr = n_err + n_half;
+        internal_mul(corr, err, n_err, half, n_half, scratch);
+        isize drop = n + h;
+        if (n_corr > drop) {
+            isize n_keep = internal_normalize(corr + drop, n_corr - drop);
+            if (too_large) {
+                internal_sub(inv, inv, n + 2, corr + drop, n_keep);
+            } else {
+                internal_add(inv, inv, n + 2, corr + drop, n_keep);
+            }
+        }
+    }
+
+    // Fix up the last few units: we want d*v <= B^(2n) < d*(v + 1).
+    isize n_inv = internal_normalize(inv, n + 2);
+    internal_mul(prod, d, n, inv, n_inv, scratch);
+    internal_zero(prod + n + n_inv, n_wide - (n + n_inv));
+    while (internal_cmp(prod, power, n_wide) == Comparison::Greater) {
+        internal_sub(prod, prod, n_wide, d, n);
+        internal_sub_digit(inv, inv, n + 2, 1);
+    }
+    for (;;) {
+        internal_add(err, prod, n_wide, d, n);
+        if (internal_cmp(err, power, n_wide) == Comparison::Greater) {
+            break;
+        }
+        internal_copy(prod, err, n_wide);
+        internal_add_digit(inv, inv, n + 2, 1);
+    }
+    rawarray_free(scratch, buffer, n_buffer);
+}
+
+/**
+ * @link
+ *      Handbook of Applied Cryptography, Algorithm 14.42. With `x < B^(2n)` the
+ *      estimate `q0` is at most 2 less than the true quotient.
+ */
+void internal_divmod_preinv(DIGIT *quot, DIGIT *rem, const DIGIT *x, isize x_len,
+    const DIGIT *d, isize n, const DIGIT *inv, const Allocator &scratch)
+{
+    assert(n <= x_len && x_len <= 2*n);
+    isize n_quot = x_len - n + 1;
+    isize n_inv  = internal_normalize(inv, n + 2);
+
+    isize  n_prod   = n_quot + n_inv;
+    isize  n_buffer = n_prod + (x_len + 1);
+    DIGIT *prod     = rawarray_new<DIGIT>(scratch, n_buffer);
+    DIGIT *diff     = prod + n_prod;
+
+    // q0 = floor(floor(x / B^(n - 1)) * inv / B^(n + 1))
+    internal_mul(prod, x + (n - 1), n_quot, inv, n_inv, scratch);
+    internal_zero(quot, n_quot);
+    if (n_prod > n + 1) {
+        isize n_q0 = internal_normalize(prod + (n + 1), n_prod - (n + 1));
+        assert(n_q0 <= n_quot);
+        internal_copy(quot, prod + (n + 1), n_q0);
+    }
+
+    // r = x - q0*d, which is non-negative and less than 3*d.
+    isize n_q0 = internal_normalize(quot, n_quot);
+    if (n_q0 > 0) {
+        internal_mul(diff, quot, n_q0, d, n, scratch);
+        internal_zero(diff + n_q0 + n, (x_len + 1) - (n_q0 + n));
+        DIGIT borrow = internal_sub(diff, x, diff, x_len);
+        assert(borrow == 0 && diff[x_len] == 0);
+        unused(borrow);
+    } else {
+        internal_copy(diff, x, x_len);
+    }
+    while (internal_cmp(diff, internal_normalize(diff, x_len), d, n) != Comparison::Less) {
+        internal_sub(diff, diff, x_len, d, n);
+        internal_add_digit(quot, quot, n_quot, 1);
+    }
+    internal_copy(rem, diff, n);
+    rawarray_free(scratch, prod, n_buffer);
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- BURNIKEL-ZIEGLER --------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      Recursive division where the divisor `b` has `n` digits with its top
+ *      bit set. Dividing `2n` digits by `n` takes two `3h / 2h` divisions with
+ *      `h = n / 2`, each of which is one `2h / h` division on the top halves
+ *      plus a multiplication to correct for the bottom half of the divisor.
+ *
+ * @link
+ *      Burnikel & Ziegler, "Fast Recursive Division", MPI-I-98-1-022, 1998.
+ */
+
+static void bz_div_3n_2n(DIGIT *q, DIGIT *r, const DIGIT *a, const DIGIT *b, isize h,
+    DIGIT *scratch, const Allocator &alloc);
+
+static bool bz_is_basecase(isize n)
+{
+    return (n & 1) != 0 || n <= bigint_burnikel_ziegler_threshold;
+}
+
+static isize bz_scratch_len(isize n)
+{
+    isize total = 0;
+    while (!bz_is_basecase(n)) {
+        // `2n / n` holds `3h` digits across its two steps, then `3h / 2h`
+        // holds `rhat` and `d` at `2h + 1` digits each.
+        isize h = n / 2;
+        total += 3*h + 2*(2*h + 1);
+        n = h;
+    }
+    // Knuth D on `2n / n` needs the `n + 1` digit quotient plus its own scratch.
+    return total + (n + 1) + (3*n + 1);
+}
+
+/**
+ * @brief
+ *      Sets `q[:n]` to `a[:2n] / b[:n]` and `r[:n]` to the remainder. Assumes
+ *      `a < b * B^n`. `r` may alias the upper half of `a`.
+ */
+static void bz_div_2n_1n(DIGIT *q, DIGIT *r, const DIGIT *a, const DIGIT *b, isize n,
+    DIGIT *scratch, const Allocator &alloc)
+{
+    if (bz_is_basecase(n)) {
+        DIGIT *quot = scratch;
+        internal_divmod_basecase(quot, r, a, 2*n, b, n, quot + (n + 1));
+        assert(quot[n] == 0);
+        internal_copy(q, quot, n);
+        return;
+    }
+    // With `a = [a1, a2, a3, a4]` in halves of `h` digits, most significant
+    // first: divide `[a1, a2, a3]`, then `[r1, r2, a4]`.
+    isize  h   = n / 2;
+    DIGIT *mid = scratch;
+    bz_div_3n_2n(q + h, mid + h, a + h, b, h, scratch + 3*h, alloc);
+    internal_copy(mid, a, h);
+    bz_div_3n_2n(q, r, mid, b, h, scratch + 3*h, alloc);
+}
+
+/**
+ * @brief
+ *      Sets `q[:h]` to `a[:3h] / b[:2h]` and `r[:2h]` to the remainder.
+ *      Assumes `a < b * B^h`.
+ */
+static void bz_div_3n_2n(DIGIT *q, DIGIT *r, const DIGIT *a, const DIGIT *b, isize h,
+    DIGIT *scratch, const Allocator &alloc)
+{
+    const DIGIT *b1   = b + h;
+    const DIGIT *b2   = b;
+    DIGIT       *rhat = scratch;
+    DIGIT       *d    = rhat + (2*h + 1);
+
+    // Estimate from the top: `q = [a1, a2] / b1`, which is at most 2 too
+    // large. If `a1 == b1` the estimate would not fit, so take `B^h - 1`.
+    if (internal_cmp(a + 2*h, b1, h) == Comparison::Less) {
+        bz_div_2n_1n(q, rhat + h, a + h, b1, h, d + (2*h + 1), alloc);
+        rhat[2*h] = 0;
+    } else {
+        for (isize i = 0; i < h; i++) {
+            q[i] = DIGIT_MAX;
+        }
+        // [a1, a2] - (B^h - 1) * b1 = a2 + b1, since a1 == b1.
+        rhat[2*h] = internal_add(rhat + h, a + h, b1, h);
+    }
+    internal_copy(rhat, a, h);
+
+    // rhat = [r1, a3] - q * b2, adding `b` back while it would be negative.
+    internal_mul(d, q, h, b2, h, alloc);
+    d[2*h] = 0;
+    while (internal_cmp(rhat, d, 2*h + 1) == Comparison::Less) {
+        internal_add(rhat, rhat, 2*h + 1, b, 2*h);
+        internal_sub_digit(q, q, h, 1);
+    }
+    internal_sub(r, rhat, d, 2*h);
+}
+
+/**
+ * @brief
+ *      Pads the divisor up to `n = j * 2^k` digits with `j` at most the
+ *      threshold, shifting it so its top bit is set, so that each level of
+ *      the recursion halves evenly down to the basecase. The dividend gets
+ *      the same shift and is then divided `n` digits at a time.
+ */
+static void bz_divmod(DIGIT *quot, DIGIT *rem, const DIGIT *x, isize x_len,
+    const DIGIT *y, isize y_len, const Allocator &alloc)
+{
+    isize m = 1;
+    while (m * bigint_burnikel_ziegler_threshold <= y_len) {
+        m *= 2;
+    }
+    isize n          = ((y_len + m - 1) / m) * m;
+    isize shift_len  = n - y_len;
+    int   shift_bits = internal_count_leading_zeros(y[y_len - 1]);
+
+    // `t` blocks of `n` digits, with the top bit of the top block clear so
+    // that it is less than the divisor.
+    isize a_len = x_len + shift_len + 1;
+    isize t     = (a_len + n - 1) / n;
+    if (t < 2) {
+        t = 2;
+    }
+
+    isize  n_quot    = (t - 1)*n;
+    isize  n_scratch = bz_scratch_len(n);
+    if (n_scratch < 4*n + 1) {
+        n_scratch = 4*n + 1;
+    }
+    isize  n_buffer  = n + t*n + n + n_quot + n_scratch;
+    DIGIT *buffer    = rawarray_new<DIGIT>(alloc, n_buffer);
+    DIGIT *bn        = buffer;
+    DIGIT *an        = bn + n;
+    DIGIT *z         = an + t*n;
+    DIGIT *qn        = z + n;
+    DIGIT *scratch   = qn + n_quot;
+
+    internal_zero(bn, shift_len);
+    internal_shl(bn + shift_len, y, y_len, shift_bits);
+    internal_zero(an, t*n);
+    an[shift_len + x_len] = internal_shl(an + shift_len, x, x_len, shift_bits);
+
+    // The top block is the first remainder. Each step then divides
+    // `[remainder so far, block i]`, copying the block just below `z` (over
+    // the top block, which has been used up) and leaving the new remainder
+    // in `z`.
+    internal_copy(z, an + (t - 1)*n, n);
+    for (isize i = t - 2; i >= 0; i--) {
+        DIGIT *block = z - n;
+        internal_copy(block, an + i*n, n);
+        // Often the top block is only the digit or so that the shift spilled
+        // over, in which case long division is far cheaper than a full step.
+        isize n_top = internal_normalize(z, n);
+        if (i == t - 2 && n_top <= bigint_burnikel_ziegler_threshold) {
+            DIGIT *r = scratch;
+            internal_zero(qn + i*n, n);
+            internal_divmod_basecase(qn + i*n, r, block, n + n_top, bn, n, r + n);
+            internal_copy(z, r, n);
+            continue;
+        }
+        bz_div_2n_1n(qn + i*n, z, block, bn, n, scratch, alloc);
+    }
+
+    isize n_out = x_len - y_len + 1;
+    assert(internal_normalize(qn, n_quot) <= n_out);
+    internal_copy(quot, qn, (n_quot < n_out) ? n_quot : n_out);
+    internal_zero(quot + n_quot, n_out - n_quot);
+    if (rem) {
+        internal_shr(rem, z + shift_len, y_len, shift_bits);
+    }
+    rawarray_free(alloc, buffer, n_buffer);
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- DISPATCH ----------------------------------------------------------- {{{1
+
+void internal_divmod(DIGIT *quot, DIGIT *rem, const DIGIT *x, isize x_len,
+    const DIGIT *y, isize y_len, const Allocator &scratch)
+{
+    assert(x_len >= y_len && y_len > 0);
+    assert(y[y_len - 1] != 0);
+    if (y_len == 1) {
+        DIGIT r = internal_div_digit(quot, x, x_len, y[0]);
+        if (rem) {
+            rem[0] = r;
+        }
+    } else if (y_len >= bigint_burnikel_ziegler_threshold
+        && x_len - y_len >= bigint_burnikel_ziegler_threshold) {
+        bz_divmod(quot, rem, x, x_len, y, y_len, scratch);
+    } else {
+        isize  n_buffer = x_len + y_len + 1;
+        DIGIT *buffer   = rawarray_new<DIGIT>(scratch, n_buffer);
+        internal_divmod_basecase(quot, rem, x, x_len, y, y_len, buffer);
+        rawarray_free(scratch, buffer, n_buffer);
+    }
+}
+
+///--- 1}}} --------------------------------------------------------------------
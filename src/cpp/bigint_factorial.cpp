@@ -0,0 +1,328 @@
+#include "bigint.hpp"
+#include "bigint_internal.hpp"
+#include "parallel.hpp"
+
+// Leaves multiplied one digit at a time at the bottom of a product tree.
+#define PRODUCT_TREE_BASECASE       16
+
+// Fewest leaves worth a thread of their own.
+#define PRODUCT_TREE_THREAD_LEAVES  4096
+
+// While `k*k < BINOMIAL_RANGE_FACTOR * n`, dividing the product of
+// `n - k + 1..n` by `k!` beats sieving up to `n`.
+#define BINOMIAL_RANGE_FACTOR       256
+
+/**
+ * @brief
+ *      Factorials, binomial coefficients and primorials. Each is a product of
+ *      prime powers, with exponents read off a sieve. Those products are
+ *      evaluated by product trees over digit-sized leaves, which keep the two
+ *      sides of every multiplication about the same size so that the fast
+ *      multiplication does the heavy lifting.
+ *
+ * @link
+ *      P. Luschny, "Fast Factorial Functions".
+ *      http://www.luschny.de/math/factorial/FastFactorialFunctions.htm
+ */
+
+///--- PRIMES ------------------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      The primes up to `n`, in order, with the sieve that found them.
+ */
+struct Primes {
+    bool  *composite;
+    isize  n_composite;
+    DIGIT *list;
+    isize  count;
+};
+
+static void primes_init(Primes *self, isize n, const Allocator &scratch)
+{
+    self->n_composite = n + 1;
+    self->composite   = rawarray_new<bool>(scratch, self->n_composite);
+    internal_sieve(self->composite, self->n_composite);
+    self->count = 0;
+    for (isize i = 0; i <= n; i++) {
+        self->count += self->composite[i] ? 0 : 1;
+    }
+    self->list = rawarray_new<DIGIT>(scratch, self->count);
+    for (isize i = 0, j = 0; i <= n; i++) {
+        if (!self->composite[i]) {
+            self->list[j++] = static_cast<DIGIT>(i);
+        }
+    }
+}
+
+static void primes_free(Primes *self, const Allocator &scratch)
+{
+    rawarray_free(scratch, self->list, self->count);
+    rawarray_free(scratch, self->composite, self->n_composite);
+}
+
+/**
+ * @brief
+ *      The exponent of the prime `p` in `n!`, by Legendre's formula.
+ */
+static isize legendre(isize n, isize p)
+{
+    isize e = 0;
+    while (n >= p) {
+        n /= p;
+        e += n;
+    }
+    return e;
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- PRODUCT TREES ------------------------------------------------------ {{{1
+
+/**
+ * @brief
+ *      Packs as many of `factors` into each leaf as fit in a digit, in place.
+ *
+ * @return
+ *      The number of leaves.
+ */
+static isize pack_leaves(DIGIT *factors, isize count)
+{
+    isize n_leaves = 0;
+    DIGIT leaf     = 1;
+    for (isize i = 0; i < count; i++) {
+        if (leaf > ~DIGIT(0) / factors[i]) {
+            factors[n_leaves++] = leaf;
+            leaf = 1;
+        }
+        leaf *= factors[i];
+    }
+    if (leaf != 1) {
+        factors[n_leaves++] = leaf;
+    }
+    return n_leaves;
+}
+
+static void product_serial(BigInt *dst, const DIGIT *leaves, isize count, const Allocator &scratch)
+{
+    if (count <= PRODUCT_TREE_BASECASE) {
+        bigint_set_from_u64(dst, 1, Sign::Positive);
+        for (isize i = 0; i < count; i++) {
+            bigint_mul_digit(dst, *dst, leaves[i]);
+        }
+        return;
+    }
+    BigInt right = bigint_make(scratch);
+    product_serial(dst, leaves, count / 2, scratch);
+    product_serial(&right, leaves + count / 2, count - count / 2, scratch);
+    bigint_mul(dst, *dst, right, scratch);
+    bigint_free(&right);
+}
+
+/**
+ * @brief
+ *      Sets `dst` to the product of `leaves`, splitting the work between up to
+ *      `thread_count` threads (the caller included).
+ *
+ * @note
+ *      Each thread multiplies out a contiguous run of leaves, then neighbours
+ *      are multiplied pairwise, in parallel, until two are left for the final
+ *      product. Only that one comes from `scratch`: the other threads allocate
+ *      from `heap_allocator`, as `scratch` need not be thread safe.
+ */
+static void product_tree(BigInt *dst, const DIGIT *leaves, isize count, isize thread_count,
+    const Allocator &scratch)
+{
+    if (thread_count > count / PRODUCT_TREE_THREAD_LEAVES) {
+        thread_count = count / PRODUCT_TREE_THREAD_LEAVES;
+    }
+    if (thread_count > PARALLEL_MAX_THREADS) {
+        thread_count = PARALLEL_MAX_THREADS;
+    }
+    if (thread_count < 2) {
+        product_serial(dst, leaves, count, scratch);
+        return;
+    }
+
+    BigInt parts[PARALLEL_MAX_THREADS];
+    for (isize i = 0; i < thread_count; i++) {
+        bigint_init(&parts[i], heap_allocator);
+    }
+    run_parallel(thread_count, [&](isize i) {
+        isize start = count * i / thread_count;
+        isize stop  = count * (i + 1) / thread_count;
+        product_serial(&parts[i], leaves + start, stop - start, heap_allocator);
+    });
+
+    auto pair_up = [&](isize i) {
+        bigint_mul(&parts[2*i], parts[2*i], parts[2*i + 1], heap_allocator);
+    };
+    isize n_parts = thread_count;
+    while (n_parts > 2) {
+        run_parallel(n_parts / 2, pair_up);
+        // Close the gaps, carrying an odd one out along.
+        for (isize i = 0; i < n_parts; i += 2) {
+            internal_bigint_swap(&parts[i / 2], &parts[i]);
+        }
+        n_parts = (n_parts + 1) / 2;
+    }
+    bigint_mul(dst, parts[0], parts[1], scratch);
+    for (isize i = 0; i < thread_count; i++) {
+        bigint_free(&parts[i]);
+    }
+}
+
+/**
+ * @brief
+ *      Sets `dst` to the product of `primes[i]^exps[i]`.
+ *
+ * @note
+ *      The odd part is the product of `P_j^(2^j)`, with `P_j` the product of
+ *      the odd primes whose exponent has bit `j` set, which Horner's rule turns
+ *      into one squaring and one product tree per bit. Powers of 2 are just a
+ *      shift at the end.
+ */
+static void prime_power_product(BigInt *dst, const DIGIT *primes, const isize *exps, isize count,
+    isize thread_count, const Allocator &scratch)
+{
+    isize twos     = 0;
+    isize max_exps = 0;
+    for (isize i = 0; i < count; i++) {
+        if (primes[i] == 2) {
+            twos = exps[i];
+        } else if (exps[i] > max_exps) {
+            max_exps = exps[i];
+        }
+    }
+    int top_bit = -1;
+    while ((max_exps >> (top_bit + 1)) != 0) {
+        top_bit++;
+    }
+
+    DIGIT *leaves = rawarray_new<DIGIT>(scratch, (count > 0) ? count : 1);
+    BigInt result = bigint_make(scratch);
+    BigInt part   = bigint_make(scratch);
+    bigint_set_from_u64(&result, 1, Sign::Positive);
+    for (int bit = top_bit; bit >= 0; bit--) {
+        internal_bigint_sqr(&part, result, scratch);
+        internal_bigint_swap(&result, &part);
+
+        isize n_leaves = 0;
+        for (isize i = 0; i < count; i++) {
+            if (primes[i] != 2 && ((exps[i] >> bit) & 1)) {
+                leaves[n_leaves++] = primes[i];
+            }
+        }
+        n_leaves = pack_leaves(leaves, n_leaves);
+        product_tree(&part, leaves, n_leaves, thread_count, scratch);
+        bigint_mul(&result, result, part, scratch);
+    }
+    internal_bigint_shl(&result, result, twos);
+    bigint_set(dst, result);
+    bigint_free(&part);
+    bigint_free(&result);
+    rawarray_free(scratch, leaves, (count > 0) ? count : 1);
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- PUBLIC API --------------------------------------------------------- {{{1
+
+bool bigint_factorial(BigInt *dst, isize n)
+{
+    return bigint_factorial(dst, n, parallel_hardware_threads(), dst->digits.allocator);
+}
+
+bool bigint_factorial(BigInt *dst, isize n, isize thread_count, const Allocator &scratch)
+{
+    if (n < 0) {
+        return false;
+    }
+    Primes primes;
+    primes_init(&primes, n, scratch);
+    isize *exps = rawarray_new<isize>(scratch, (primes.count > 0) ? primes.count : 1);
+    for (isize i = 0; i < primes.count; i++) {
+        exps[i] = legendre(n, static_cast<isize>(primes.list[i]));
+    }
+    prime_power_product(dst, primes.list, exps, primes.count, thread_count, scratch);
+    rawarray_free(scratch, exps, (primes.count > 0) ? primes.count : 1);
+    primes_free(&primes, scratch);
+    return true;
+}
+
+void bigint_binomial(BigInt *dst, isize n, isize k)
+{
+    bigint_binomial(dst, n, k, parallel_hardware_threads(), dst->digits.allocator);
+}
+
+/**
+ * @note
+ *      By Kummer's theorem, the exponent of `p` is the number of carries when
+ *      adding `k` and `n - k` in base `p`, which Legendre's formula gives as
+ *      the difference of those of `n!`, `k!` and `(n - k)!`.
+ */
+void bigint_binomial(BigInt *dst, isize n, isize k, isize thread_count, const Allocator &scratch)
+{
+    // C(n, k) = (-1)^k C(k - n - 1, k) takes care of negative `n`.
+    bool negate = false;
+    if (n < 0 && k >= 0) {
+        n      = k - n - 1;
+        negate = (k % 2) != 0;
+    }
+    if (k < 0 || k > n) {
+        bigint_clear(dst);
+        return;
+    }
+    if (k > n - k) {
+        k = n - k;
+    }
+
+    if (k == 0 || k / BINOMIAL_RANGE_FACTOR < n / k) {
+        DIGIT *leaves = rawarray_new<DIGIT>(scratch, (k > 0) ? k : 1);
+        BigInt top    = bigint_make(scratch);
+        BigInt bottom = bigint_make(scratch);
+        for (isize i = 0; i < k; i++) {
+            leaves[i] = static_cast<DIGIT>(n - i);
+        }
+        product_tree(&top, leaves, pack_leaves(leaves, k), thread_count, scratch);
+        bigint_factorial(&bottom, k, thread_count, scratch);
+        bigint_divmod(dst, nullptr, top, bottom, scratch);
+        bigint_free(&bottom);
+        bigint_free(&top);
+        rawarray_free(scratch, leaves, (k > 0) ? k : 1);
+    } else {
+        Primes primes;
+        primes_init(&primes, n, scratch);
+        isize *exps = rawarray_new<isize>(scratch, (primes.count > 0) ? primes.count : 1);
+        for (isize i = 0; i < primes.count; i++) {
+            isize p = static_cast<isize>(primes.list[i]);
+            exps[i] = legendre(n, p) - legendre(k, p) - legendre(n - k, p);
+        }
+        prime_power_product(dst, primes.list, exps, primes.count, thread_count, scratch);
+        rawarray_free(scratch, exps, (primes.count > 0) ? primes.count : 1);
+        primes_free(&primes, scratch);
+    }
+    if (negate) {
+        bigint_neg(dst, *dst);
+    }
+}
+
+void bigint_primorial(BigInt *dst, isize n)
+{
+    bigint_primorial(dst, n, parallel_hardware_threads(), dst->digits.allocator);
+}
+
+void bigint_primorial(BigInt *dst, isize n, isize thread_count, const Allocator &scratch)
+{
+    if (n < 2) {
+        bigint_set_from_u64(dst, 1, Sign::Positive);
+        return;
+    }
+    Primes primes;
+    primes_init(&primes, n, scratch);
+    isize n_leaves = pack_leaves(primes.list, primes.count);
+    product_tree(dst, primes.list, n_leaves, thread_count, scratch);
+    primes_free(&primes, scratch);
+}
+
+///--- 1}}} --------------------------------------------------------------------
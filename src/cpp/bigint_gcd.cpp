@@ -0,0 +1,904 @@
+#include "bigint.hpp"
+#include "bigint_internal.hpp"
+
+/**
+ * @brief
+ *      Greatest common divisors. Operands of up to two digits go through
+ *      binary GCD on a double word. Larger ones go through Lehmer's algorithm,
+ *      which replaces each run of Euclidean steps by a single 2x2 matrix worked
+ *      out from the leading double digit. Past `bigint_hgcd_threshold` digits,
+ *      half-GCD finds such matrices recursively from the leading half of the
+ *      digits, so that the cost follows multiplication instead.
+ *
+ * @note
+ *      A matrix `M` relates the pair we started from to the current one by
+ *      `(a, b) = M (a', b')`. Its entries are non-negative and its determinant
+ *      is -1 to the number of steps it stands for, so `M^-1` is the adjugate
+ *      of `M`, negated if that number is odd.
+ *
+ * @link
+ *      The Art of Computer Programming, Vol. 2, Section 4.5.2.
+ *      https://github.com/python/cpython/blob/main/Objects/longobject.c
+ *      (`_PyLong_GCD`, for the exact Lehmer condition).
+ *      N. Möller, "On Schönhage's algorithm and subquadratic integer GCD
+ *      computation", Math. Comp. 77 (2008).
+ */
+
+isize bigint_hgcd_threshold = BIGINT_HGCD_THRESHOLD;
+
+#if defined(BIGINT_HAS_INT128) && !defined(_MSC_VER)
+    __extension__ typedef unsigned __int128 Window;
+    #define WINDOW_DIGITS   2
+#else
+    typedef DIGIT Window;
+    #define WINDOW_DIGITS   1
+#endif
+
+// Leading bits that Lehmer steps look at, leaving room for the cofactors.
+static const isize WINDOW_BITS = 8*size_of(Window) - 4;
+
+///--- DOUBLE WORDS ------------------------------------------------------- {{{1
+
+static Window window_load(const BigInt &x)
+{
+    assert(len(x.digits) <= WINDOW_DIGITS);
+    Window value = 0;
+    for (isize i = 0; i < len(x.digits); i++) {
+        value |= static_cast<Window>(x.digits[i]) << (DIGIT_BITS * i);
+    }
+    return value;
+}
+
+static void bigint_set_window(BigInt *dst, Window value)
+{
+    DIGIT digits[WINDOW_DIGITS];
+    isize n_len = 0;
+    for (isize i = 0; i < WINDOW_DIGITS; i++) {
+        digits[i] = static_cast<DIGIT>(value >> (DIGIT_BITS * i));
+        if (digits[i] != 0) {
+            n_len = i + 1;
+        }
+    }
+    DIGIT *out = internal_bigint_grow(dst, n_len);
+    internal_copy(out, digits, n_len);
+    dst->sign = Sign::Positive;
+    internal_bigint_trim(dst, n_len);
+}
+
+static int window_trailing_zeros(Window x)
+{
+    assert(x != 0);
+    for (isize i = 0;; i++) {
+        DIGIT digit = static_cast<DIGIT>(x >> (DIGIT_BITS * i));
+        if (digit != 0) {
+            return static_cast<int>(DIGIT_BITS*i) + internal_count_trailing_zeros(digit);
+        }
+    }
+}
+
+/**
+ * @brief
+ *      Stein's algorithm: strip the common factors of two, then keep
+ *      subtracting the smaller odd number from the larger one.
+ */
+static Window gcd_window(Window x, Window y)
+{
+    if (x == 0) {
+        return y;
+    } else if (y == 0) {
+        return x;
+    }
+    int shift = window_trailing_zeros(x | y);
+    x >>= window_trailing_zeros(x);
+    do {
+        y >>= window_trailing_zeros(y);
+        if (x > y) {
+            Window tmp = x;
+            x = y;
+            y = tmp;
+        }
+        y -= x;
+    } while (y != 0);
+    return x << shift;
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- MATRICES ----------------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      What a run of Lehmer steps (or the Euclidean steps on single digits)
+ *      amounts to. Entries fit in a digit.
+ */
+struct Lehmer_Matrix {
+    DIGIT m[2][2];
+    bool  odd;
+};
+
+/**
+ * @brief
+ *      Product of any number of steps, entries unbounded.
+ */
+struct Gcd_Matrix {
+    BigInt m[2][2];
+    bool   odd;
+};
+
+/**
+ * @brief
+ *      Temporaries for the matrix operations below, which never run while
+ *      another one is using them.
+ */
+struct Gcd_Temps {
+    Allocator scratch;
+    BigInt    tmp[3];
+};
+
+static void gcd_temps_init(Gcd_Temps *self, const Allocator &scratch)
+{
+    self->scratch = scratch;
+    for (BigInt &tmp : self->tmp) {
+        bigint_init(&tmp, scratch);
+    }
+}
+
+static void gcd_temps_free(Gcd_Temps *self)
+{
+    for (BigInt &tmp : self->tmp) {
+        bigint_free(&tmp);
+    }
+}
+
+static void matrix_init(Gcd_Matrix *self, const Allocator &a)
+{
+    for (isize i = 0; i < 2; i++) {
+        for (isize j = 0; j < 2; j++) {
+            bigint_init(&self->m[i][j], a);
+            bigint_set_from_u64(&self->m[i][j], (i == j) ? 1 : 0, Sign::Positive);
+        }
+    }
+    self->odd = false;
+}
+
+static void matrix_free(Gcd_Matrix *self)
+{
+    for (isize i = 0; i < 2; i++) {
+        for (isize j = 0; j < 2; j++) {
+            bigint_free(&self->m[i][j]);
+        }
+    }
+}
+
+/**
+ * @note
+ *      With non-negative entries and a determinant of 1, zeros off the
+ *      diagonal leave only 1s on it.
+ */
+static bool matrix_is_identity(const Gcd_Matrix &self)
+{
+    return !self.odd && bigint_is_zero(self.m[0][1]) && bigint_is_zero(self.m[1][0]);
+}
+
+/**
+ * @brief
+ *      Bit length of the largest entry.
+ */
+static isize matrix_bit_len(const Gcd_Matrix &self)
+{
+    isize bits = 0;
+    for (isize i = 0; i < 2; i++) {
+        for (isize j = 0; j < 2; j++) {
+            isize n_bits = bigint_bit_len(self.m[i][j]);
+            if (n_bits > bits) {
+                bits = n_bits;
+            }
+        }
+    }
+    return bits;
+}
+
+/**
+ * @brief
+ *      `self = self * [[0, 1], [1, 0]]`, for when `a` and `b` swap places.
+ */
+static void matrix_swap_columns(Gcd_Matrix *self)
+{
+    internal_bigint_swap(&self->m[0][0], &self->m[0][1]);
+    internal_bigint_swap(&self->m[1][0], &self->m[1][1]);
+    self->odd = !self->odd;
+}
+
+static void matrix_entry_mul(BigInt *dst, const BigInt &x, const BigInt &y, const Allocator &scratch)
+{
+    bigint_mul(dst, x, y, scratch);
+}
+
+static void matrix_entry_mul(BigInt *dst, const BigInt &x, DIGIT y, const Allocator &scratch)
+{
+    unused(scratch);
+    bigint_mul_digit(dst, x, y);
+}
+
+/**
+ * @brief
+ *      `self = self * other`. With `bottom_only`, the top row is left as it
+ *      was, for callers that never look at it.
+ */
+template<class Matrix>
+static void matrix_mul(Gcd_Matrix *self, const Matrix &other, bool bottom_only, Gcd_Temps *temps)
+{
+    BigInt *tmp = temps->tmp;
+    for (isize i = bottom_only ? 1 : 0; i < 2; i++) {
+        BigInt *row = self->m[i];
+        matrix_entry_mul(&tmp[0], row[0], other.m[0][0], temps->scratch);
+        matrix_entry_mul(&tmp[2], row[1], other.m[1][0], temps->scratch);
+        bigint_add(&tmp[0], tmp[0], tmp[2]);
+        matrix_entry_mul(&tmp[1], row[0], other.m[0][1], temps->scratch);
+        matrix_entry_mul(&tmp[2], row[1], other.m[1][1], temps->scratch);
+        bigint_add(&tmp[1], tmp[1], tmp[2]);
+        internal_bigint_swap(&row[0], &tmp[0]);
+        internal_bigint_swap(&row[1], &tmp[1]);
+    }
+    self->odd = (self->odd != other.odd);
+}
+
+/**
+ * @brief
+ *      `self = self * [[q, 1], [1, 0]]`, i.e. one Euclidean step.
+ */
+static void matrix_mul_quotient(Gcd_Matrix *self, const BigInt &q, bool bottom_only, Gcd_Temps *temps)
+{
+    BigInt *tmp = &temps->tmp[0];
+    for (isize i = bottom_only ? 1 : 0; i < 2; i++) {
+        BigInt *row = self->m[i];
+        bigint_mul(tmp, row[0], q, temps->scratch);
+        bigint_add(tmp, *tmp, row[1]);
+        internal_bigint_swap(&row[1], &row[0]);
+        internal_bigint_swap(&row[0], tmp);
+    }
+    self->odd = !self->odd;
+}
+
+/**
+ * @brief
+ *      `(a, b) = self^-1 (a, b)`.
+ */
+static void matrix_apply_inverse(const Gcd_Matrix &self, BigInt *a, BigInt *b, Gcd_Temps *temps)
+{
+    BigInt *tmp = temps->tmp;
+    bigint_mul(&tmp[0], self.m[1][1], *a, temps->scratch);
+    bigint_mul(&tmp[2], self.m[0][1], *b, temps->scratch);
+    bigint_sub(&tmp[0], tmp[0], tmp[2]);
+    bigint_mul(&tmp[1], self.m[0][0], *b, temps->scratch);
+    bigint_mul(&tmp[2], self.m[1][0], *a, temps->scratch);
+    bigint_sub(&tmp[1], tmp[1], tmp[2]);
+    if (self.odd) {
+        bigint_neg(&tmp[0], tmp[0]);
+        bigint_neg(&tmp[1], tmp[1]);
+    }
+    internal_bigint_swap(a, &tmp[0]);
+    internal_bigint_swap(b, &tmp[1]);
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- LEHMER STEPS ------------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      Bits `[shift, shift + WINDOW_BITS)` of `x`, assuming none are set above.
+ */
+static Window window_at(const BigInt &x, isize shift)
+{
+    isize  index = shift / DIGIT_BITS;
+    isize  bit   = shift % DIGIT_BITS;
+    Window value = 0;
+    for (isize i = 0; i <= WINDOW_DIGITS && index + i < len(x.digits); i++) {
+        Window digit = x.digits[index + i];
+        if (i == 0) {
+            value = digit >> bit;
+        } else if (DIGIT_BITS*i - bit < 8*size_of(Window)) {
+            value |= digit << (DIGIT_BITS*i - bit);
+        }
+    }
+    return value;
+}
+
+static isize window_bit_len(Window x)
+{
+    for (isize i = WINDOW_DIGITS - 1; i >= 0; i--) {
+        DIGIT digit = static_cast<DIGIT>(x >> (DIGIT_BITS * i));
+        if (digit != 0) {
+            return DIGIT_BITS*(i + 1) - internal_count_leading_zeros(digit);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief
+ *      Runs Euclid on the leading bits of `a >= b` for as long as each
+ *      quotient provably matches the one `a` and `b` themselves would give.
+ *      With `matrix_bits >= 0`, also stops before the remainder shrinks to
+ *      about the size of the cofactors plus that many bits, for half-GCD.
+ *
+ * @note
+ *      `A..D` are the cofactors as CPython names them: each step is taken
+ *      only if the quotient agrees for both ends of the interval the true
+ *      ratio lies in, and the cofactors stay below the remainders (Collins'
+ *      condition). Those also keep every product here within the window.
+ *
+ * @return
+ *      false if not even one step is certain, in which case a division has
+ *      to make progress instead.
+ */
+static bool lehmer_simulate(Lehmer_Matrix *self, const BigInt &a, const BigInt &b, isize matrix_bits)
+{
+    isize  bits  = bigint_bit_len(a);
+    isize  shift = (bits > WINDOW_BITS) ? bits - WINDOW_BITS : 0;
+    Window x     = window_at(a, shift);
+    Window y     = window_at(b, shift);
+
+    Window A = 1, B = 0, C = 0, D = 1;
+    isize  steps = 0;
+    while (y > C) {
+        // Most quotients are 1, which needs no division.
+        Window q = 1;
+        Window t = x - y;
+        if (t >= y) {
+            q = x / y;
+            t = x - q*y;
+        }
+        Window s = B + q*D;
+        if (s > t || t + (A - 1) + (q + 1)*C >= y) {
+            break;
+        }
+        Window u = A + q*C;
+        if (matrix_bits >= 0
+            && shift + window_bit_len(t) <= matrix_bits + window_bit_len((s > u) ? s : u) + 3) {
+            break;
+        }
+        x = y;
+        y = t;
+        A = D;
+        B = C;
+        C = s;
+        D = u;
+        steps++;
+    }
+    if (steps == 0) {
+        return false;
+    }
+
+    // The cofactors trade places every step.
+    self->odd = (steps % 2) != 0;
+    Window m[2][2] = {{D, B}, {C, A}};
+    if (self->odd) {
+        m[0][0] = C;
+        m[0][1] = A;
+        m[1][0] = D;
+        m[1][1] = B;
+    }
+    for (isize i = 0; i < 2; i++) {
+        for (isize j = 0; j < 2; j++) {
+            self->m[i][j] = static_cast<DIGIT>(m[i][j]);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief
+ *      Sets `dst[:n]` to `u*x - v*y`, which must be in `0..<B^n`.
+ */
+static void lehmer_combine(DIGIT *dst, const DIGIT *x, DIGIT u, const DIGIT *y, DIGIT v, isize n)
+{
+    DIGIT upper = internal_mul_digit(dst, x, n, u);
+    upper -= internal_mul_sub_digit(dst, y, n, v);
+    assert(upper == 0);
+    unused(upper);
+}
+
+/**
+ * @brief
+ *      Sets `(new_a, new_b)` to `self^-1 (a, b)`. `b` gets padded with zero
+ *      digits in place, but keeps its value.
+ */
+static void lehmer_apply(const Lehmer_Matrix &self, BigInt *new_a, BigInt *new_b, BigInt *a, BigInt *b)
+{
+    isize  n   = len(a->digits);
+    isize  n_b = len(b->digits);
+    DIGIT *x   = internal_bigint_grow(a, n);
+    DIGIT *y   = internal_bigint_grow(b, n);
+    internal_zero(y + n_b, n - n_b);
+
+    DIGIT *out_a = internal_bigint_grow(new_a, n);
+    DIGIT *out_b = internal_bigint_grow(new_b, n);
+    if (self.odd) {
+        lehmer_combine(out_a, y, self.m[0][1], x, self.m[1][1], n);
+        lehmer_combine(out_b, x, self.m[1][0], y, self.m[0][0], n);
+    } else {
+        lehmer_combine(out_a, x, self.m[1][1], y, self.m[0][1], n);
+        lehmer_combine(out_b, y, self.m[0][0], x, self.m[1][0], n);
+    }
+    new_a->sign = Sign::Positive;
+    new_b->sign = Sign::Positive;
+    internal_bigint_trim(new_a, n);
+    internal_bigint_trim(new_b, n);
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- HALF-GCD ----------------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      Whether `(a, b)` may stop at `M`. Both have to stay at least twice the
+ *      largest entry of `M`: then `M^-1` applied to any number that has
+ *      `(a, b)` as its leading digits still gives non-negative values, which
+ *      again satisfy this (see `hgcd`).
+ */
+static bool hgcd_is_reduced(const BigInt &a, const BigInt &b, isize matrix_bits)
+{
+    isize bits = bigint_bit_len(b);
+    if (bigint_bit_len(a) < bits) {
+        bits = bigint_bit_len(a);
+    }
+    return bits > matrix_bits + 1;
+}
+
+/**
+ * @brief
+ *      One Euclidean step on `a >= b`, folded into `M`.
+ *
+ * @return
+ *      false, touching nothing, if it would leave `(a, b)` not reduced.
+ */
+static bool hgcd_step(Gcd_Matrix *M, BigInt *a, BigInt *b, BigInt *q, BigInt *r, Gcd_Temps *temps)
+{
+    if (bigint_is_zero(*b)) {
+        return false;
+    }
+    bigint_divmod(q, r, *a, *b, temps->scratch);
+
+    // With `q >= 1` the new left column holds the largest entries.
+    BigInt *tmp  = temps->tmp;
+    isize   bits = 0;
+    for (isize i = 0; i < 2; i++) {
+        if (len(q->digits) == 1) {
+            bigint_mul_digit(&tmp[i], M->m[i][0], q->digits[0]);
+        } else {
+            bigint_mul(&tmp[i], M->m[i][0], *q, temps->scratch);
+        }
+        bigint_add(&tmp[i], tmp[i], M->m[i][1]);
+        if (bigint_bit_len(tmp[i]) > bits) {
+            bits = bigint_bit_len(tmp[i]);
+        }
+    }
+    if (!hgcd_is_reduced(*b, *r, bits)) {
+        return false;
+    }
+    for (isize i = 0; i < 2; i++) {
+        internal_bigint_swap(&M->m[i][1], &M->m[i][0]);
+        internal_bigint_swap(&M->m[i][0], &tmp[i]);
+    }
+    M->odd = !M->odd;
+    internal_bigint_swap(a, b);
+    internal_bigint_swap(b, r);
+    return true;
+}
+
+/**
+ * @brief
+ *      Quadratic half-GCD: Lehmer steps for as long as they keep `(a, b)`
+ *      reduced, then single steps for the last few bits.
+ */
+static void hgcd_lehmer(Gcd_Matrix *M, BigInt *a, BigInt *b, Gcd_Temps *temps)
+{
+    BigInt new_a = bigint_make(temps->scratch);
+    BigInt new_b = bigint_make(temps->scratch);
+    for (;;) {
+        Lehmer_Matrix N;
+        if (!lehmer_simulate(&N, *a, *b, matrix_bit_len(*M))) {
+            if (!hgcd_step(M, a, b, &new_a, &new_b, temps)) {
+                break;
+            }
+            continue;
+        }
+        // Bound the entries of `M * N` rather than work them out twice.
+        DIGIT largest = 1;
+        for (isize i = 0; i < 2; i++) {
+            for (isize j = 0; j < 2; j++) {
+                largest = (N.m[i][j] > largest) ? N.m[i][j] : largest;
+            }
+        }
+        isize bits = matrix_bit_len(*M) + (DIGIT_BITS - internal_count_leading_zeros(largest)) + 1;
+        lehmer_apply(N, &new_a, &new_b, a, b);
+        if (!hgcd_is_reduced(new_a, new_b, bits)) {
+            while (hgcd_step(M, a, b, &new_a, &new_b, temps)) {
+            }
+            break;
+        }
+        internal_bigint_swap(a, &new_a);
+        internal_bigint_swap(b, &new_b);
+        matrix_mul(M, N, false, temps);
+    }
+    bigint_free(&new_b);
+    bigint_free(&new_a);
+}
+
+/**
+ * @brief
+ *      Sets `dst` to `x` without its lowest `n` digits.
+ */
+static void bigint_set_high_digits(BigInt *dst, const BigInt &x, isize n)
+{
+    isize n_len = len(x.digits) - n;
+    if (n_len <= 0) {
+        bigint_clear(dst);
+        return;
+    }
+    DIGIT *out = internal_bigint_grow(dst, n_len);
+    internal_copy(out, cbegin(x.digits) + n, n_len);
+    dst->sign = Sign::Positive;
+    internal_bigint_trim(dst, n_len);
+}
+
+/**
+ * @brief
+ *      `dst += x B^n`.
+ */
+static void bigint_add_shifted(BigInt *dst, const BigInt &x, isize n, Gcd_Temps *temps)
+{
+    BigInt *tmp = &temps->tmp[0];
+    isize n_len = len(x.digits) + n;
+    DIGIT *out  = internal_bigint_grow(tmp, n_len);
+    internal_zero(out, n);
+    internal_copy(out + n, cbegin(x.digits), len(x.digits));
+    tmp->sign = Sign::Positive;
+    internal_bigint_trim(tmp, n_len);
+    bigint_add(dst, *dst, *tmp);
+}
+
+/**
+ * @brief
+ *      Given that `R` reduced the leading digits of `(a, b)`, from the `n`th
+ *      on, to `(x, y)`, sets `(a, b)` to `R^-1 (a, b)` and `M` to `M * R`,
+ *      keeping `a >= b`.
+ *
+ * @note
+ *      Only the low digits go through `R^-1`: the rest is `B^n (x, y)`.
+ */
+static void hgcd_lift(Gcd_Matrix *M, const Gcd_Matrix &R, BigInt *a, BigInt *b,
+                      const BigInt &x, const BigInt &y, isize n, Gcd_Temps *temps)
+{
+    internal_bigint_trim(a, (len(a->digits) < n) ? len(a->digits) : n);
+    internal_bigint_trim(b, (len(b->digits) < n) ? len(b->digits) : n);
+    matrix_apply_inverse(R, a, b, temps);
+    bigint_add_shifted(a, x, n, temps);
+    bigint_add_shifted(b, y, n, temps);
+    assert(!bigint_is_neg(*a) && !bigint_is_neg(*b));
+    matrix_mul(M, R, false, temps);
+    if (bigint_cmp(*a, *b) == Comparison::Less) {
+        internal_bigint_swap(a, b);
+        matrix_swap_columns(M);
+    }
+}
+
+/**
+ * @brief
+ *      Sets `M` (the identity on entry) and `(a, b) = M^-1 (a, b)` so that
+ *      `a >= b` are still reduced in the sense of `hgcd_is_reduced`, but only
+ *      about half as long as `a` was.
+ *
+ * @note
+ *      Say `R` reduces the leading digits `(a1, b1)` of `a = a1 B^p + a0` and
+ *      `b = b1 B^p + b0` to `(x, y)`. Then `R^-1 (a, b) = B^p (x, y) + e` with
+ *      each part of `e` within `B^p max(R)` of zero. As `x, y >= 2 max(R)`,
+ *      that leaves the lifted pair above `B^p max(R)`, which is enough for it
+ *      to be reduced by `R` too, and by `M * R` when `B^p >= 4 max(M)`.
+ *
+ *      So we reduce the leading half, lift, and do it again with the leading
+ *      half of what is left, each time at a split below which `M` vanishes.
+ */
+static void hgcd(Gcd_Matrix *M, BigInt *a, BigInt *b, Gcd_Temps *temps)
+{
+    isize n = len(a->digits);
+    if (n < bigint_hgcd_threshold) {
+        hgcd_lehmer(M, a, b, temps);
+        return;
+    }
+    Gcd_Matrix R;
+    matrix_init(&R, temps->scratch);
+    BigInt a_high = bigint_make(temps->scratch);
+    BigInt b_high = bigint_make(temps->scratch);
+
+    bigint_set_high_digits(&a_high, *a, n / 2);
+    bigint_set_high_digits(&b_high, *b, n / 2);
+    hgcd(&R, &a_high, &b_high, temps);
+    bool progress = true;
+    if (!matrix_is_identity(R)) {
+        hgcd_lift(M, R, a, b, a_high, b_high, n / 2, temps);
+    } else {
+        progress = hgcd_step(M, a, b, &a_high, &b_high, temps);
+    }
+
+    isize split = (matrix_bit_len(*M) + 2 + DIGIT_BITS - 1) / DIGIT_BITS;
+    if (progress && len(b->digits) > split) {
+        matrix_free(&R);
+        matrix_init(&R, temps->scratch);
+        bigint_set_high_digits(&a_high, *a, split);
+        bigint_set_high_digits(&b_high, *b, split);
+        hgcd(&R, &a_high, &b_high, temps);
+        if (!matrix_is_identity(R)) {
+            hgcd_lift(M, R, a, b, a_high, b_high, split, temps);
+        }
+    }
+    // Rounding `split` to digits can leave most of one to go.
+    if (progress) {
+        hgcd_lehmer(M, a, b, temps);
+    }
+
+    bigint_free(&b_high);
+    bigint_free(&a_high);
+    matrix_free(&R);
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- EUCLID ------------------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      A GCD in progress: the pair `a >= b` and, if `track`, the bottom row
+ *      of the matrix taking it back to the input.
+ */
+struct Gcd_State {
+    BigInt     a, b;
+    BigInt     spare_a, spare_b;
+    Gcd_Matrix M;
+    bool       track;
+    Gcd_Temps  temps;
+};
+
+static void gcd_state_init(Gcd_State *self, const BigInt &x, const BigInt &y, bool track, const Allocator &scratch)
+{
+    gcd_temps_init(&self->temps, scratch);
+    matrix_init(&self->M, scratch);
+    self->track = track;
+    bigint_init(&self->a, scratch);
+    bigint_init(&self->b, scratch);
+    bigint_init(&self->spare_a, scratch);
+    bigint_init(&self->spare_b, scratch);
+    bigint_abs(&self->a, x);
+    bigint_abs(&self->b, y);
+    if (bigint_cmp(self->a, self->b) == Comparison::Less) {
+        internal_bigint_swap(&self->a, &self->b);
+        matrix_swap_columns(&self->M);
+    }
+}
+
+static void gcd_state_free(Gcd_State *self)
+{
+    bigint_free(&self->spare_b);
+    bigint_free(&self->spare_a);
+    bigint_free(&self->b);
+    bigint_free(&self->a);
+    matrix_free(&self->M);
+    gcd_temps_free(&self->temps);
+}
+
+static void gcd_divide_step(Gcd_State *self)
+{
+    BigInt *q = &self->spare_a;
+    BigInt *r = &self->spare_b;
+    bigint_divmod(q, r, self->a, self->b, self->temps.scratch);
+    if (self->track) {
+        matrix_mul_quotient(&self->M, *q, true, &self->temps);
+    }
+    internal_bigint_swap(&self->a, &self->b);
+    internal_bigint_swap(&self->b, r);
+}
+
+/**
+ * @brief
+ *      Plain Euclid once both fit in a digit, collecting its steps into one
+ *      matrix, whose entries are bounded by `a`.
+ */
+static void gcd_word_steps(Gcd_State *self)
+{
+    DIGIT         x = self->a.digits[0];
+    DIGIT         y = self->b.digits[0];
+    Lehmer_Matrix N = {{{1, 0}, {0, 1}}, false};
+    while (y != 0) {
+        DIGIT q = x / y;
+        DIGIT r = x - q*y;
+        x = y;
+        y = r;
+        for (isize i = 0; i < 2; i++) {
+            DIGIT m0  = N.m[i][0];
+            N.m[i][0] = m0*q + N.m[i][1];
+            N.m[i][1] = m0;
+        }
+        N.odd = !N.odd;
+    }
+    matrix_mul(&self->M, N, true, &self->temps);
+    bigint_set_from_u64(&self->a, x, Sign::Positive);
+    bigint_clear(&self->b);
+}
+
+/**
+ * @brief
+ *      Reduces the pair until `b` is 0, leaving the GCD in `a`.
+ */
+static void gcd_reduce(Gcd_State *self)
+{
+    while (!bigint_is_zero(self->b)) {
+        isize n = len(self->a.digits);
+        if (!self->track && n <= WINDOW_DIGITS) {
+            bigint_set_window(&self->a, gcd_window(window_load(self->a), window_load(self->b)));
+            bigint_clear(&self->b);
+            break;
+        } else if (self->track && n == 1) {
+            gcd_word_steps(self);
+            break;
+        }
+
+        if (len(self->b.digits) >= bigint_hgcd_threshold) {
+            Gcd_Matrix R;
+            matrix_init(&R, self->temps.scratch);
+            hgcd(&R, &self->a, &self->b, &self->temps);
+            bool progress = !matrix_is_identity(R);
+            if (progress && self->track) {
+                matrix_mul(&self->M, R, true, &self->temps);
+            }
+            matrix_free(&R);
+            if (progress) {
+                continue;
+            }
+        } else {
+            Lehmer_Matrix N;
+            if (lehmer_simulate(&N, self->a, self->b, -1)) {
+                lehmer_apply(N, &self->spare_a, &self->spare_b, &self->a, &self->b);
+                internal_bigint_swap(&self->a, &self->spare_a);
+                internal_bigint_swap(&self->b, &self->spare_b);
+                if (self->track) {
+                    matrix_mul(&self->M, N, true, &self->temps);
+                }
+                continue;
+            }
+        }
+        gcd_divide_step(self);
+    }
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- PUBLIC API --------------------------------------------------------- {{{1
+
+void bigint_gcd(BigInt *dst, const BigInt &x, const BigInt &y)
+{
+    bigint_gcd(dst, x, y, dst->digits.allocator);
+}
+
+void bigint_gcd(BigInt *dst, const BigInt &x, const BigInt &y, const Allocator &scratch)
+{
+    if (len(x.digits) <= WINDOW_DIGITS && len(y.digits) <= WINDOW_DIGITS) {
+        bigint_set_window(dst, gcd_window(window_load(x), window_load(y)));
+        return;
+    }
+    Gcd_State state;
+    gcd_state_init(&state, x, y, false, scratch);
+    gcd_reduce(&state);
+    bigint_set(dst, state.a);
+    gcd_state_free(&state);
+}
+
+void bigint_lcm(BigInt *dst, const BigInt &x, const BigInt &y)
+{
+    bigint_lcm(dst, x, y, dst->digits.allocator);
+}
+
+void bigint_lcm(BigInt *dst, const BigInt &x, const BigInt &y, const Allocator &scratch)
+{
+    if (bigint_is_zero(x) || bigint_is_zero(y)) {
+        bigint_clear(dst);
+        return;
+    }
+    BigInt g = bigint_make(scratch);
+    bigint_gcd(&g, x, y, scratch);
+    bigint_divmod(&g, nullptr, x, g, scratch);
+    bigint_mul(dst, g, y, scratch);
+    dst->sign = Sign::Positive;
+    bigint_free(&g);
+}
+
+void bigint_gcd_ext(BigInt *gcd, BigInt *s, BigInt *t, const BigInt &x, const BigInt &y)
+{
+    assert(gcd || s || t);
+    const BigInt *some = gcd ? gcd : (s ? s : t);
+    bigint_gcd_ext(gcd, s, t, x, y, some->digits.allocator);
+}
+
+void bigint_gcd_ext(BigInt *gcd, BigInt *s, BigInt *t, const BigInt &x, const BigInt &y,
+    const Allocator &scratch)
+{
+    Gcd_State state;
+    gcd_state_init(&state, x, y, true, scratch);
+    gcd_reduce(&state);
+
+    // `|x| = m11 g` and `g = +-(m22 |x| - m12 |y|)`, with the sign of the
+    // determinant, so the cofactor of `|x|` is `+-m22`.
+    BigInt *g        = &state.a;
+    BigInt *s_cofact = &state.M.m[1][1];
+    if (state.M.odd) {
+        bigint_neg(s_cofact, *s_cofact);
+    }
+    if (bigint_is_zero(*g)) {
+        bigint_clear(s_cofact);
+    }
+    BigInt *t_cofact = &state.b;
+    if (t) {
+        // `t = (g - s |x|) / |y|`, exactly.
+        if (bigint_is_zero(y)) {
+            bigint_clear(t_cofact);
+        } else {
+            BigInt *tmp = &state.spare_a;
+            bigint_abs(&state.spare_b, y);
+            bigint_abs(tmp, x);
+            bigint_mul(tmp, *tmp, *s_cofact, scratch);
+            bigint_sub(tmp, *g, *tmp);
+            bigint_divmod(t_cofact, nullptr, *tmp, state.spare_b, scratch);
+        }
+        if (bigint_is_neg(y)) {
+            bigint_neg(t_cofact, *t_cofact);
+        }
+    }
+    if (bigint_is_neg(x)) {
+        bigint_neg(s_cofact, *s_cofact);
+    }
+
+    // Only now, as the outputs may alias `x` and `y`.
+    if (gcd) {
+        bigint_set(gcd, *g);
+    }
+    if (s) {
+        bigint_set(s, *s_cofact);
+    }
+    if (t) {
+        bigint_set(t, *t_cofact);
+    }
+    gcd_state_free(&state);
+}
+
+bool bigint_mod_inverse(BigInt *dst, const BigInt &x, const BigInt &modulus)
+{
+    return bigint_mod_inverse(dst, x, modulus, dst->digits.allocator);
+}
+
+bool bigint_mod_inverse(BigInt *dst, const BigInt &x, const BigInt &modulus, const Allocator &scratch)
+{
+    if (bigint_is_zero(modulus)) {
+        return false;
+    }
+    BigInt g = bigint_make(scratch);
+    BigInt s = bigint_make(scratch);
+    BigInt m = bigint_make(scratch);
+    bigint_gcd_ext(&g, &s, nullptr, x, modulus, scratch);
+    bool ok = (bigint_cmp_digit(g, 1) == Comparison::Equal);
+    if (ok) {
+        bigint_abs(&m, modulus);
+        bigint_divmod(nullptr, &s, s, m, scratch);
+        if (bigint_is_neg(s)) {
+            bigint_add(&s, s, m);
+        }
+        bigint_set(dst, s);
+    }
+    bigint_free(&m);
+    bigint_free(&s);
+    bigint_free(&g);
+    return ok;
+}
+
+///--- 1}}} --------------------------------------------------------------------
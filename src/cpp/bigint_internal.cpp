@@ -0,0 +1,348 @@
+#include "bigint_internal.hpp"
+
+#include <cstring>
+
+///--- DIGIT VECTORS ------------------------------------------------------ {{{1
+
+isize internal_normalize(const DIGIT *x, isize len)
+{
+    while (len > 0 && x[len - 1] == 0) {
+        len--;
+    }
+    return len;
+}
+
+Comparison internal_cmp(const DIGIT *x, const DIGIT *y, isize len)
+{
+    // Most significant digits have the final say.
+    for (isize i = len - 1; i >= 0; i--) {
+        if (x[i] != y[i]) {
+            return (x[i] < y[i]) ? Comparison::Less : Comparison::Greater;
+        }
+    }
+    return Comparison::Equal;
+}
+
+Comparison internal_cmp(const DIGIT *x, isize x_len, const DIGIT *y, isize y_len)
+{
+    if (x_len != y_len) {
+        return (x_len < y_len) ? Comparison::Less : Comparison::Greater;
+    }
+    return internal_cmp(x, y, x_len);
+}
+
+void internal_zero(DIGIT *dst, isize len)
+{
+    if (len > 0) {
+        std::memset(dst, 0, size_of(DIGIT) * len);
+    }
+}
+
+void internal_copy(DIGIT *dst, const DIGIT *src, isize len)
+{
+    if (len > 0 && dst != src) {
+        std::memmove(dst, src, size_of(DIGIT) * len);
+    }
+}
+
+DIGIT internal_shl(DIGIT *dst, const DIGIT *x, isize len, int shift)
+{
+    if (shift == 0) {
+        internal_copy(dst, x, len);
+        return 0;
+    }
+    // Go from most to least significant so `dst` may alias `x`.
+    DIGIT out = 0;
+    if (len > 0) {
+        out = x[len - 1] >> (DIGIT_BITS - shift);
+    }
+    for (isize i = len - 1; i > 0; i--) {
+        dst[i] = (x[i] << shift) | (x[i - 1] >> (DIGIT_BITS - shift));
+    }
+    if (len > 0) {
+        dst[0] = x[0] << shift;
+    }
+    return out;
+}
+
+DIGIT internal_shr(DIGIT *dst, const DIGIT *x, isize len, int shift)
+{
+    if (shift == 0) {
+        internal_copy(dst, x, len);
+        return 0;
+    }
+    DIGIT out = 0;
+    if (len > 0) {
+        out = x[0] << (DIGIT_BITS - shift);
+    }
+    for (isize i = 0; i < len - 1; i++) {
+        dst[i] = (x[i] >> shift) | (x[i + 1] << (DIGIT_BITS - shift));
+    }
+    if (len > 0) {
+        dst[len - 1] = x[len - 1] >> shift;
+    }
+    return out;
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- ARITHMETIC --------------------------------------------------------- {{{1
+
+DIGIT internal_add(DIGIT *dst, const DIGIT *x, const DIGIT *y, isize len)
+{
+    DIGIT carry = 0;
+    for (isize i = 0; i < len; i++) {
+        DIGIT sum = x[i] + carry;
+        carry     = (sum < carry);
+        sum      += y[i];
+        carry    += (sum < y[i]);
+        dst[i]    = sum;
+    }
+    return carry;
+}
+
+DIGIT internal_add(DIGIT *dst, const DIGIT *x, isize x_len, const DIGIT *y, isize y_len)
+{
+    assert(x_len >= y_len);
+    DIGIT carry = internal_add(dst, x, y, y_len);
+    return internal_add_digit(dst + y_len, x + y_len, x_len - y_len, carry);
+}
+
+DIGIT internal_add_digit(DIGIT *dst, const DIGIT *x, isize x_len, DIGIT y)
+{
+    DIGIT carry = y;
+    isize i     = 0;
+    for (; i < x_len && carry != 0; i++) {
+        DIGIT sum = x[i] + carry;
+        carry     = (sum < carry);
+        dst[i]    = sum;
+    }
+    // No more carries to propagate, so the rest is a plain copy.
+    internal_copy(dst + i, x + i, x_len - i);
+    return carry;
+}
+
+DIGIT internal_sub(DIGIT *dst, const DIGIT *x, const DIGIT *y, isize len)
+{
+    DIGIT borrow = 0;
+    for (isize i = 0; i < len; i++) {
+        DIGIT lhs  = x[i];
+        DIGIT rhs  = y[i] + borrow;
+        borrow     = (rhs < borrow) | (lhs < rhs);
+        dst[i]     = lhs - rhs;
+    }
+    return borrow;
+}
+
+DIGIT internal_sub(DIGIT *dst, const DIGIT *x, isize x_len, const DIGIT *y, isize y_len)
+{
+    assert(x_len >= y_len);
+    DIGIT borrow = internal_sub(dst, x, y, y_len);
+    return internal_sub_digit(dst + y_len, x + y_len, x_len - y_len, borrow);
+}
+
+DIGIT internal_sub_digit(DIGIT *dst, const DIGIT *x, isize x_len, DIGIT y)
+{
+    DIGIT borrow = y;
+    isize i      = 0;
+    for (; i < x_len && borrow != 0; i++) {
+        DIGIT lhs = x[i];
+        dst[i]    = lhs - borrow;
+        borrow    = (lhs < borrow);
+    }
+    internal_copy(dst + i, x + i, x_len - i);
+    return borrow;
+}
+
+DIGIT internal_mul_digit(DIGIT *dst, const DIGIT *x, isize len, DIGIT y)
+{
+    DIGIT carry = 0;
+    for (isize i = 0; i < len; i++) {
+        DIGIT upper;
+        DIGIT lower = internal_mul_wide(x[i], y, &upper);
+        lower      += carry;
+        carry       = upper + (lower < carry);
+        dst[i]      = lower;
+    }
+    return carry;
+}
+
+DIGIT internal_mul_add_digit(DIGIT *dst, const DIGIT *x, isize len, DIGIT y)
+{
+    DIGIT carry = 0;
+    for (isize i = 0; i < len; i++) {
+        DIGIT upper;
+        DIGIT lower = internal_mul_wide(x[i], y, &upper);
+        lower      += carry;
+        upper      += (lower < carry);
+        lower      += dst[i];
+        upper      += (lower < dst[i]);
+        dst[i]      = lower;
+        carry       = upper;
+    }
+    return carry;
+}
+
+DIGIT internal_mul_sub_digit(DIGIT *dst, const DIGIT *x, isize len, DIGIT y)
+{
+    DIGIT borrow = 0;
+    for (isize i = 0; i < len; i++) {
+        DIGIT upper;
+        DIGIT lower = internal_mul_wide(x[i], y, &upper);
+        lower      += borrow;
+        upper      += (lower < borrow);
+        DIGIT prev  = dst[i];
+        dst[i]      = prev - lower;
+        borrow      = upper + (prev < lower);
+    }
+    return borrow;
+}
+
+/**
+ * @brief
+ *      Each row `dst[i:i + x_len]` accumulates `x * y[i]`; the carry out of
+ *      each row lands in the one digit that has not been written yet.
+ */
+void internal_mul_basecase(DIGIT *dst, const DIGIT *x, isize x_len, const DIGIT *y, isize y_len)
+{
+    assert(x_len >= y_len && y_len > 0);
+    dst[x_len] = internal_mul_digit(dst, x, x_len, y[0]);
+    for (isize i = 1; i < y_len; i++) {
+        dst[x_len + i] = internal_mul_add_digit(dst + i, x, x_len, y[i]);
+    }
+}
+
+void internal_sqr_basecase(DIGIT *dst, const DIGIT *x, isize len)
+{
+    assert(len > 0);
+    // Each cross product `x[i] * x[j]` (i < j) appears twice in the square, so
+    // compute it once and double the lot afterwards.
+    internal_zero(dst, 2*len);
+    for (isize i = 0; i < len - 1; i++) {
+        dst[len + i] = internal_mul_add_digit(dst + 2*i + 1, x + i + 1, len - i - 1, x[i]);
+    }
+    DIGIT top = internal_shl(dst, dst, 2*len, 1);
+    assert(top == 0);
+    unused(top);
+
+    // Then add the squares along the diagonal.
+    DIGIT carry = 0;
+    for (isize i = 0; i < len; i++) {
+        DIGIT upper;
+        DIGIT lower = internal_mul_wide(x[i], x[i], &upper);
+        DIGIT sum;
+        DIGIT c = internal_add_overflow(dst[2*i], lower, &sum);
+        c         += internal_add_overflow(sum, carry, &dst[2*i]);
+        carry      = internal_add_overflow(dst[2*i + 1], upper, &sum);
+        carry     += internal_add_overflow(sum, c, &dst[2*i + 1]);
+    }
+    assert(carry == 0);
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- BIGINT HELPERS ----------------------------------------------------- {{{1
+
+DIGIT *internal_bigint_grow(BigInt *self, isize n_len)
+{
+    array_reserve(&self->digits, n_len);
+    return begin(self->digits);
+}
+
+void internal_bigint_trim(BigInt *self, isize n_len)
+{
+    self->digits.len = internal_normalize(begin(self->digits), n_len);
+    if (self->digits.len == 0) {
+        self->sign = Sign::Positive;
+    }
+}
+
+void internal_bigint_swap(BigInt *x, BigInt *y)
+{
+    BigInt tmp = *x;
+    *x = *y;
+    *y = tmp;
+}
+
+void internal_bigint_shl(BigInt *dst, const BigInt &x, isize bits)
+{
+    assert(bits >= 0);
+    isize n_x = len(x.digits);
+    if (n_x == 0) {
+        bigint_clear(dst);
+        return;
+    }
+    isize words = bits / DIGIT_BITS;
+    int   shift = static_cast<int>(bits % DIGIT_BITS);
+    Sign  sign  = x.sign;
+    isize n_len = n_x + words + 1;
+    // Grow first: if `dst` aliases `x`, its buffer may move. `internal_shl`
+    // goes from the top down, so moving the digits up within it is fine.
+    DIGIT *out     = internal_bigint_grow(dst, n_len);
+    out[n_len - 1] = internal_shl(out + words, cbegin(x.digits), n_x, shift);
+    internal_zero(out, words);
+    dst->sign = sign;
+    internal_bigint_trim(dst, n_len);
+}
+
+void internal_bigint_shr(BigInt *dst, const BigInt &x, isize bits)
+{
+    assert(bits >= 0);
+    isize n_x   = len(x.digits);
+    isize words = bits / DIGIT_BITS;
+    if (words >= n_x) {
+        bigint_clear(dst);
+        return;
+    }
+    int   shift = static_cast<int>(bits % DIGIT_BITS);
+    Sign  sign  = x.sign;
+    isize n_len = n_x - words;
+    DIGIT *out  = internal_bigint_grow(dst, n_len);
+    internal_shr(out, cbegin(x.digits) + words, n_len, shift);
+    dst->sign = sign;
+    internal_bigint_trim(dst, n_len);
+}
+
+void internal_bigint_sqr(BigInt *dst, const BigInt &x, const Allocator &scratch)
+{
+    assert(dst != &x);
+    isize n_x = len(x.digits);
+    if (n_x == 0) {
+        bigint_clear(dst);
+        return;
+    }
+    isize  n_len     = 2*n_x;
+    isize  n_scratch = internal_mul_scratch_len(n_x, n_x);
+    DIGIT *buffer    = nullptr;
+    if (n_scratch > 0) {
+        buffer = rawarray_new<DIGIT>(scratch, n_scratch);
+    }
+    DIGIT *out = internal_bigint_grow(dst, n_len);
+    internal_sqr(out, cbegin(x.digits), n_x, buffer);
+    if (buffer) {
+        rawarray_free(scratch, buffer, n_scratch);
+    }
+    dst->sign = Sign::Positive;
+    internal_bigint_trim(dst, n_len);
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- PRIMES ------------------------------------------------------------- {{{1
+
+void internal_sieve(bool *composite, isize n)
+{
+    for (isize i = 0; i < n; i++) {
+        composite[i] = (i < 2);
+    }
+    for (isize p = 2; p * p < n; p++) {
+        if (composite[p]) {
+            continue;
+        }
+        for (isize multiple = p * p; multiple < n; multiple += p) {
+            composite[multiple] = true;
+        }
+    }
+}
+
+///--- 1}}} --------------------------------------------------------------------
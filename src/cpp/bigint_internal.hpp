@@ -0,0 +1,429 @@
+#pragma once
+
+/**
+ * @brief
+ *      Digit-vector kernels shared by the `bigint_*.cpp` translation units.
+ *      Not meant to be included by users of `bigint.hpp`.
+ *
+ * @note
+ *      Unless stated otherwise, these functions do not consider signedness and
+ *      operate on raw little-endian digit buffers. `dst` may alias an input
+ *      only if it points to the very start of that input.
+ */
+
+#include "bigint.hpp"
+
+#if defined(__SIZEOF_INT128__)
+    #define BIGINT_HAS_INT128
+#elif defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+///--- DOUBLE-WIDTH HELPERS ----------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      Returns the lower half of `x * y` and writes the upper half to `*upper`.
+ */
+inline DIGIT internal_mul_wide(DIGIT x, DIGIT y, DIGIT *upper)
+{
+#if defined(BIGINT_HAS_INT128)
+    __extension__ typedef unsigned __int128 u128;
+    u128 prod = static_cast<u128>(x) * static_cast<u128>(y);
+    *upper = static_cast<DIGIT>(prod >> DIGIT_BITS);
+    return static_cast<DIGIT>(prod);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return _umul128(x, y, upper);
+#else
+    // Portable fallback: schoolbook multiplication in 32-bit halves.
+    u64 x0 = x & 0xffffffff, x1 = x >> 32;
+    u64 y0 = y & 0xffffffff, y1 = y >> 32;
+    u64 p00 = x0 * y0;
+    u64 p01 = x0 * y1;
+    u64 p10 = x1 * y0;
+    u64 p11 = x1 * y1;
+    u64 mid = (p00 >> 32) + (p01 & 0xffffffff) + (p10 & 0xffffffff);
+    *upper = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+    return (mid << 32) | (p00 & 0xffffffff);
+#endif
+}
+
+/**
+ * @brief
+ *      Number of leading zero bits in `x`. Assumes `x != 0`.
+ */
+inline int internal_count_leading_zeros(DIGIT x)
+{
+    assert(x != 0);
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanReverse64(&index, x);
+    return 63 - static_cast<int>(index);
+#else
+    int n = 0;
+    while (!(x & (static_cast<DIGIT>(1) << (DIGIT_BITS - 1)))) {
+        x <<= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+/**
+ * @brief
+ *      Number of trailing zero bits in `x`. Assumes `x != 0`.
+ */
+inline int internal_count_trailing_zeros(DIGIT x)
+{
+    assert(x != 0);
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return static_cast<int>(index);
+#else
+    int n = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+/**
+ * @brief
+ *      Divides the double-width value `upper:lower` by `divisor`, writing the
+ *      remainder to `*rem`. Assumes `upper < divisor` so the quotient fits.
+ */
+inline DIGIT internal_div_wide(DIGIT upper, DIGIT lower, DIGIT divisor, DIGIT *rem)
+{
+    assert(upper < divisor);
+#if defined(BIGINT_HAS_INT128) && !defined(_MSC_VER)
+    __extension__ typedef unsigned __int128 u128;
+    u128 num = (static_cast<u128>(upper) << DIGIT_BITS) | lower;
+    *rem = static_cast<DIGIT>(num % divisor);
+    return static_cast<DIGIT>(num / divisor);
+#else
+    /**
+     * @brief
+     *      Long division in 32-bit halves with a normalized divisor, so each
+     *      estimated half-quotient is off by at most 2.
+     *
+     * @link
+     *      Hacker's Delight, 2nd ed., Figure 9-3 (divlu).
+     */
+    const u64 half_base = static_cast<u64>(1) << 32;
+    const u64 half_mask = half_base - 1;
+
+    int shift = internal_count_leading_zeros(divisor);
+    divisor <<= shift;
+    u64 d1 = divisor >> 32;
+    u64 d0 = divisor & half_mask;
+
+    u64 n32 = (shift == 0) ? upper : (upper << shift) | (lower >> (DIGIT_BITS - shift));
+    u64 n10 = lower << shift;
+    u64 n1  = n10 >> 32;
+    u64 n0  = n10 & half_mask;
+
+    u64 q1   = n32 / d1;
+    u64 rhat = n32 - q1*d1;
+    while (q1 >= half_base || q1*d0 > half_base*rhat + n1) {
+        q1--;
+        rhat += d1;
+        if (rhat >= half_base) {
+            break;
+        }
+    }
+    u64 n21 = n32*half_base + n1 - q1*divisor;
+    u64 q0  = n21 / d1;
+    rhat    = n21 - q0*d1;
+    while (q0 >= half_base || q0*d0 > half_base*rhat + n0) {
+        q0--;
+        rhat += d1;
+        if (rhat >= half_base) {
+            break;
+        }
+    }
+    *rem = (n21*half_base + n0 - q0*divisor) >> shift;
+    return q1*half_base + q0;
+#endif
+}
+
+/**
+ * @brief
+ *      Writes `x + y` modulo the base to `*sum` and returns whether it carried
+ *      out, i.e. the add-with-carry flag.
+ */
+inline bool internal_add_overflow(DIGIT x, DIGIT y, DIGIT *sum)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_add_overflow(x, y, sum);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return _addcarry_u64(0, x, y, sum) != 0;
+#else
+    *sum = x + y;
+    return *sum < x;
+#endif
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- DIGIT VECTORS ------------------------------------------------------ {{{1
+
+/**
+ * @brief
+ *      Returns `len` minus the number of leading zero digits of `x`.
+ */
+isize internal_normalize(const DIGIT *x, isize len);
+
+Comparison internal_cmp(const DIGIT *x, const DIGIT *y, isize len);
+Comparison internal_cmp(const DIGIT *x, isize x_len, const DIGIT *y, isize y_len);
+
+void internal_zero(DIGIT *dst, isize len);
+void internal_copy(DIGIT *dst, const DIGIT *src, isize len);
+
+/**
+ * @brief
+ *      Sets `dst[:len]` to `x[:len] << shift` and returns the bits shifted out.
+ *      Assumes `0 <= shift < DIGIT_BITS`.
+ */
+DIGIT internal_shl(DIGIT *dst, const DIGIT *x, isize len, int shift);
+
+/**
+ * @brief
+ *      Sets `dst[:len]` to `x[:len] >> shift` and returns the bits shifted out,
+ *      in the upper bits of the result. Assumes `0 <= shift < DIGIT_BITS`.
+ */
+DIGIT internal_shr(DIGIT *dst, const DIGIT *x, isize len, int shift);
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- ARITHMETIC --------------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      Sets `dst[:len]` to `x[:len] + y[:len]` and returns the carry (0 or 1).
+ */
+DIGIT internal_add(DIGIT *dst, const DIGIT *x, const DIGIT *y, isize len);
+
+/**
+ * @brief
+ *      Sets `dst[:x_len]` to `x + y` and returns the carry.
+ *      Assumes `x_len >= y_len`.
+ */
+DIGIT internal_add(DIGIT *dst, const DIGIT *x, isize x_len, const DIGIT *y, isize y_len);
+DIGIT internal_add_digit(DIGIT *dst, const DIGIT *x, isize x_len, DIGIT y);
+
+/**
+ * @brief
+ *      Sets `dst[:len]` to `x[:len] - y[:len]` and returns the borrow (0 or 1).
+ */
+DIGIT internal_sub(DIGIT *dst, const DIGIT *x, const DIGIT *y, isize len);
+
+/**
+ * @brief
+ *      Sets `dst[:x_len]` to `x - y` and returns the borrow.
+ *      Assumes `x_len >= y_len`.
+ */
+DIGIT internal_sub(DIGIT *dst, const DIGIT *x, isize x_len, const DIGIT *y, isize y_len);
+DIGIT internal_sub_digit(DIGIT *dst, const DIGIT *x, isize x_len, DIGIT y);
+
+/**
+ * @brief
+ *      Sets `dst[:len]` to `x[:len] * y` and returns the most significant digit
+ *      of the product.
+ */
+DIGIT internal_mul_digit(DIGIT *dst, const DIGIT *x, isize len, DIGIT y);
+
+/**
+ * @brief
+ *      Adds `x[:len] * y` into `dst[:len]` and returns the carry digit.
+ */
+DIGIT internal_mul_add_digit(DIGIT *dst, const DIGIT *x, isize len, DIGIT y);
+
+/**
+ * @brief
+ *      Subtracts `x[:len] * y` from `dst[:len]` and returns the borrow digit.
+ */
+DIGIT internal_mul_sub_digit(DIGIT *dst, const DIGIT *x, isize len, DIGIT y);
+
+/**
+ * @brief
+ *      Long multiplication. Sets `dst[:x_len + y_len]` to `x * y`.
+ *      Assumes `x_len >= y_len > 0` and that `dst` does not alias `x` or `y`.
+ */
+void internal_mul_basecase(DIGIT *dst, const DIGIT *x, isize x_len, const DIGIT *y, isize y_len);
+
+/**
+ * @brief
+ *      Long squaring. Sets `dst[:2 * len]` to `x * x`, with about half the
+ *      digit products of `internal_mul_basecase`. Assumes `len > 0` and that
+ *      `dst` does not alias `x`.
+ */
+void internal_sqr_basecase(DIGIT *dst, const DIGIT *x, isize len);
+
+/**
+ * @brief
+ *      Sets `dst[:x_len + y_len]` to `x * y`, picking long multiplication,
+ *      Karatsuba, Toom-3 or the NTT by size. Operands may come in any order and be of
+ *      any length. `dst` must not alias `x` or `y`.
+ *
+ * @note
+ *      Scratch space for the whole recursion is allocated once from `scratch`.
+ */
+void internal_mul(DIGIT *dst, const DIGIT *x, isize x_len, const DIGIT *y, isize y_len, const Allocator &scratch);
+
+/**
+ * @brief
+ *      Like the above, for callers that multiply over and over and would
+ *      rather allocate once: `scratch` must hold at least
+ *      `internal_mul_scratch_len(x_len, y_len)` digits.
+ */
+void  internal_mul(DIGIT *dst, const DIGIT *x, isize x_len, const DIGIT *y, isize y_len, DIGIT *scratch);
+isize internal_mul_scratch_len(isize x_len, isize y_len);
+
+/**
+ * @brief
+ *      Sets `dst[:2 * len]` to `x * x`. Below `bigint_sqr_karatsuba_threshold`
+ *      this takes the long squaring path. `scratch` is as for `internal_mul`
+ *      with two operands of `len` digits.
+ */
+void internal_sqr(DIGIT *dst, const DIGIT *x, isize len, DIGIT *scratch);
+
+/**
+ * @brief
+ *      Sets `dst[:x_len + y_len]` to `x * y` using a 3-prime NTT. Any operand
+ *      order and length is fine. `scratch` must hold at least
+ *      `internal_mul_ntt_scratch_len(x_len, y_len)` digits.
+ */
+void  internal_mul_ntt(DIGIT *dst, const DIGIT *x, isize x_len, const DIGIT *y, isize y_len, DIGIT *scratch);
+isize internal_mul_ntt_scratch_len(isize x_len, isize y_len);
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- DIVISION ----------------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      Sets `quot[:len]` to `x[:len] / y` and returns the remainder. `quot` may
+ *      alias `x`. Assumes `y != 0`.
+ */
+DIGIT internal_div_digit(DIGIT *quot, const DIGIT *x, isize len, DIGIT y);
+
+/**
+ * @brief
+ *      `x[:len] % y`, for when the quotient is of no use. Assumes `y != 0`.
+ */
+DIGIT internal_mod_digit(const DIGIT *x, isize len, DIGIT y);
+
+/**
+ * @brief
+ *      Knuth's Algorithm D. Sets `quot[:x_len - y_len + 1]` to `x / y` and
+ *      `rem[:y_len]` to `x % y`. `rem` may be null.
+ *
+ * @note
+ *      Assumes `x_len >= y_len > 0` and `y[y_len - 1] != 0`. Neither output may
+ *      alias an input. `scratch` needs `x_len + y_len + 1` digits.
+ */
+void internal_divmod_basecase(DIGIT *quot, DIGIT *rem, const DIGIT *x, isize x_len,
+    const DIGIT *y, isize y_len, DIGIT *scratch);
+
+/**
+ * @brief
+ *      Sets `inv[:n + 2]` to `floor(B^(2n) / d)` where `d` is `n` digits and
+ *      `B = 2^64`, via Newton's iteration on the fast multiplier.
+ *
+ * @note
+ *      Assumes `d[n - 1] != 0`. Intended for divisors that are reused many
+ *      times, e.g. the powers of the radix in string conversion.
+ */
+void internal_reciprocal(DIGIT *inv, const DIGIT *d, isize n, const Allocator &scratch);
+
+/**
+ * @brief
+ *      Barrett division by `d` (`n` digits) given `inv` from
+ *      `internal_reciprocal`. Sets `quot[:x_len - n + 1]` and `rem[:n]`.
+ *
+ * @note
+ *      Assumes `n <= x_len <= 2*n` and `d[n - 1] != 0`. Costs two
+ *      multiplications instead of a quadratic division.
+ */
+void internal_divmod_preinv(DIGIT *quot, DIGIT *rem, const DIGIT *x, isize x_len,
+    const DIGIT *d, isize n, const DIGIT *inv, const Allocator &scratch);
+
+/**
+ * @brief
+ *      Sets `quot[:x_len - y_len + 1]` to `x / y` and `rem[:y_len]` to `x % y`,
+ *      picking single digit division, Knuth D or Burnikel-Ziegler by size.
+ *      `rem` may be null. Neither output may alias an input.
+ *
+ * @note
+ *      Assumes `x_len >= y_len > 0` and `y[y_len - 1] != 0`.
+ */
+void internal_divmod(DIGIT *quot, DIGIT *rem, const DIGIT *x, isize x_len,
+    const DIGIT *y, isize y_len, const Allocator &scratch);
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- BIGINT HELPERS ----------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      Ensures `self` has room for `n_len` digits, preserving the current
+ *      ones, then returns a writable pointer to its buffer.
+ *
+ * @note
+ *      The purpose of this function is only to grow; `len(self->digits)` is
+ *      unchanged. Call `internal_bigint_trim` after writing.
+ */
+DIGIT *internal_bigint_grow(BigInt *self, isize n_len);
+
+/**
+ * @brief
+ *      Sets the active count to `n_len` minus any leading zero digits. If this
+ *      turns us into zero, the sign is reset to positive.
+ */
+void internal_bigint_trim(BigInt *self, isize n_len);
+
+/**
+ * @brief
+ *      Exchanges the values of `x` and `y`, buffers and all.
+ */
+void internal_bigint_swap(BigInt *x, BigInt *y);
+
+/**
+ * @brief
+ *      Sets `dst` to `x` with its magnitude shifted up by `bits`. `dst` may
+ *      alias `x`.
+ */
+void internal_bigint_shl(BigInt *dst, const BigInt &x, isize bits);
+
+/**
+ * @brief
+ *      Sets `dst` to `x` with its magnitude shifted down by `bits`, which is
+ *      `x / 2^bits` rounded toward zero. `dst` may alias `x`.
+ */
+void internal_bigint_shr(BigInt *dst, const BigInt &x, isize bits);
+
+/**
+ * @brief
+ *      `dst = x^2`, through the squaring kernels. `dst` may not alias `x`.
+ */
+void internal_bigint_sqr(BigInt *dst, const BigInt &x, const Allocator &scratch);
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- PRIMES ------------------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      Sieve of Eratosthenes over `0..<n`: sets `composite[i]` to whether `i`
+ *      is not a prime, so 0 and 1 count as composite.
+ */
+void internal_sieve(bool *composite, isize n);
+
+///--- 1}}} --------------------------------------------------------------------
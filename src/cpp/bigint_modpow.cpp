@@ -0,0 +1,562 @@
+#include "bigint.hpp"
+#include "bigint_internal.hpp"
+#include "parallel.hpp"
+
+#include <atomic>
+
+// Fewest digit products (roughly `n*n` per modular multiply, one or so per
+// exponent bit) worth a thread of their own.
+#define MODPOW_BATCH_THREAD_WORK    (1 << 20)
+
+// Each worker's scratch starts on its own cache line (8 digits).
+#define MODPOW_BATCH_WORKER_ALIGN   8
+
+/**
+ * @brief
+ *      Modular exponentiation. Odd moduli go through Montgomery multiplication,
+ *      so the inner loop never divides; even ones fall back to plain square
+ *      and multiply with a division per step.
+ *
+ * @link
+ *      Handbook of Applied Cryptography, 14.36 (Montgomery reduction) and
+ *      14.85 (sliding-window exponentiation).
+ */
+
+///--- KERNELS ------------------------------------------------------------ {{{1
+
+/**
+ * @brief
+ *      Sets `dst[:n]` to `t * R^-1 mod m`, consuming `t[:2n]`. Assumes `t < m*R`,
+ *      which holds for any product of two residues.
+ *
+ * @note
+ *      Row `i` zeroes `t[i]`, so that is where we park its carry out, which
+ *      belongs at `t[i + n]`. Adding the parked carries in one go at the end
+ *      saves propagating each of them through the upper half.
+ */
+static void montgomery_redc(const Montgomery &self, DIGIT *dst, DIGIT *t)
+{
+    isize        n = self.len;
+    const DIGIT *m = self.modulus;
+    for (isize i = 0; i < n; i++) {
+        DIGIT u = t[i] * self.inv;
+        t[i]    = internal_mul_add_digit(t + i, m, n, u);
+    }
+    // The result is below 2m, so at most one subtraction brings it in range.
+    DIGIT carry = internal_add(dst, t + n, t, n);
+    if (carry != 0 || internal_cmp(dst, m, n) != Comparison::Less) {
+        internal_sub(dst, dst, m, n);
+    }
+}
+
+/**
+ * @brief
+ *      Scratch digits for one product and its reduction.
+ */
+static isize kernel_scratch_len(const Montgomery &self)
+{
+    return 2*self.len + internal_mul_scratch_len(self.len, self.len);
+}
+
+static void montgomery_mul(const Montgomery &self, DIGIT *dst, const DIGIT *x, const DIGIT *y, DIGIT *scratch)
+{
+    DIGIT *t = scratch;
+    internal_mul(t, x, self.len, y, self.len, scratch + 2*self.len);
+    montgomery_redc(self, dst, t);
+}
+
+static void montgomery_sqr(const Montgomery &self, DIGIT *dst, const DIGIT *x, DIGIT *scratch)
+{
+    DIGIT *t = scratch;
+    internal_sqr(t, x, self.len, scratch + 2*self.len);
+    montgomery_redc(self, dst, t);
+}
+
+/**
+ * @brief
+ *      Sets `dst[:n]` to `|x| mod m` (zero-padded), dividing only if `x` has
+ *      more digits than `m`.
+ */
+static void residue_abs(const Montgomery &self, DIGIT *dst, const BigInt &x, const Allocator &scratch)
+{
+    isize n   = self.len;
+    isize n_x = len(x.digits);
+    if (n_x <= n) {
+        internal_copy(dst, cbegin(x.digits), n_x);
+        internal_zero(dst + n_x, n - n_x);
+        return;
+    }
+    isize  n_quot = n_x - n + 1;
+    DIGIT *quot   = rawarray_new<DIGIT>(scratch, n_quot);
+    internal_divmod(quot, dst, cbegin(x.digits), n_x, self.modulus, n, scratch);
+    rawarray_free(scratch, quot, n_quot);
+}
+
+/**
+ * @brief
+ *      Sets `dst[:n]` to the Montgomery form of `x`, i.e. `x * R mod m`.
+ *
+ * @note
+ *      `residue_abs` may leave a value as big as `R - 1`, but multiplying by
+ *      `R^2 mod m` still keeps the product below `m*R`.
+ */
+static void montgomery_convert(const Montgomery &self, DIGIT *dst, const BigInt &x, DIGIT *kernel,
+    const Allocator &scratch)
+{
+    isize n = self.len;
+    residue_abs(self, dst, x, scratch);
+    montgomery_mul(self, dst, dst, self.r2, kernel);
+    if (bigint_is_neg(x) && internal_normalize(dst, n) != 0) {
+        internal_sub(dst, self.modulus, dst, n);
+    }
+}
+
+/**
+ * @brief
+ *      Writes the residue `x[:n]` to `dst` as a non-negative `BigInt`.
+ */
+static void bigint_set_residue(BigInt *dst, const DIGIT *x, isize n)
+{
+    DIGIT *out = internal_bigint_grow(dst, n);
+    internal_copy(out, x, n);
+    dst->sign = Sign::Positive;
+    internal_bigint_trim(dst, n);
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- MONTGOMERY CONTEXT ------------------------------------------------- {{{1
+
+bool montgomery_init(Montgomery *self, const BigInt &modulus, const Allocator &a)
+{
+    isize n = len(modulus.digits);
+    if (n == 0 || (modulus.digits[0] & 1) == 0) {
+        return false;
+    }
+    DIGIT *buffer = rawarray_new<DIGIT>(a, 2*n);
+    self->allocator = a;
+    self->modulus   = buffer;
+    self->r2        = buffer + n;
+    self->len       = n;
+    internal_copy(self->modulus, cbegin(modulus.digits), n);
+
+    // An odd number is its own inverse modulo 2^3, and each Newton step
+    // doubles the number of correct low bits: 3, 6, 12, 24, 48, 96.
+    DIGIT m0  = self->modulus[0];
+    DIGIT inv = m0;
+    for (int i = 0; i < 5; i++) {
+        inv *= 2 - m0*inv;
+    }
+    self->inv = 0 - inv;
+
+    // R^2 = B^(2n), which takes 2n + 1 digits.
+    isize  n_num  = 2*n + 1;
+    isize  n_quot = n_num - n + 1;
+    DIGIT *num    = rawarray_new<DIGIT>(a, n_num + n_quot);
+    DIGIT *quot   = num + n_num;
+    internal_zero(num, n_num);
+    num[2*n] = 1;
+    internal_divmod(quot, self->r2, num, n_num, self->modulus, n, a);
+    rawarray_free(a, num, n_num + n_quot);
+    return true;
+}
+
+void montgomery_free(Montgomery *self)
+{
+    rawarray_free(self->allocator, self->modulus, 2*self->len);
+    self->modulus = nullptr;
+    self->r2      = nullptr;
+    self->len     = 0;
+}
+
+void montgomery_to(const Montgomery &self, BigInt *dst, const BigInt &x)
+{
+    montgomery_to(self, dst, x, dst->digits.allocator);
+}
+
+void montgomery_to(const Montgomery &self, BigInt *dst, const BigInt &x, const Allocator &scratch)
+{
+    isize  n        = self.len;
+    isize  n_kernel = kernel_scratch_len(self);
+    DIGIT *buffer   = rawarray_new<DIGIT>(scratch, n + n_kernel);
+    montgomery_convert(self, buffer, x, buffer + n, scratch);
+    bigint_set_residue(dst, buffer, n);
+    rawarray_free(scratch, buffer, n + n_kernel);
+}
+
+void montgomery_from(const Montgomery &self, BigInt *dst, const BigInt &x)
+{
+    montgomery_from(self, dst, x, dst->digits.allocator);
+}
+
+void montgomery_from(const Montgomery &self, BigInt *dst, const BigInt &x, const Allocator &scratch)
+{
+    isize n   = self.len;
+    isize n_x = len(x.digits);
+    assert(n_x <= n);
+    DIGIT *t = rawarray_new<DIGIT>(scratch, 2*n);
+    internal_copy(t, cbegin(x.digits), n_x);
+    internal_zero(t + n_x, 2*n - n_x);
+    montgomery_redc(self, t, t);
+    bigint_set_residue(dst, t, n);
+    rawarray_free(scratch, t, 2*n);
+}
+
+void montgomery_mul(const Montgomery &self, BigInt *dst, const BigInt &x, const BigInt &y)
+{
+    montgomery_mul(self, dst, x, y, dst->digits.allocator);
+}
+
+void montgomery_mul(const Montgomery &self, BigInt *dst, const BigInt &x, const BigInt &y, const Allocator &scratch)
+{
+    isize n = self.len;
+    assert(len(x.digits) <= n && len(y.digits) <= n);
+    isize  n_kernel = kernel_scratch_len(self);
+    DIGIT *buffer   = rawarray_new<DIGIT>(scratch, 2*n + n_kernel);
+    DIGIT *x_pad    = buffer;
+    DIGIT *y_pad    = buffer + n;
+    internal_copy(x_pad, cbegin(x.digits), len(x.digits));
+    internal_zero(x_pad + len(x.digits), n - len(x.digits));
+    internal_copy(y_pad, cbegin(y.digits), len(y.digits));
+    internal_zero(y_pad + len(y.digits), n - len(y.digits));
+    montgomery_mul(self, x_pad, x_pad, y_pad, buffer + 2*n);
+    bigint_set_residue(dst, x_pad, n);
+    rawarray_free(scratch, buffer, 2*n + n_kernel);
+}
+
+void montgomery_sqr(const Montgomery &self, BigInt *dst, const BigInt &x)
+{
+    montgomery_sqr(self, dst, x, dst->digits.allocator);
+}
+
+void montgomery_sqr(const Montgomery &self, BigInt *dst, const BigInt &x, const Allocator &scratch)
+{
+    isize n = self.len;
+    assert(len(x.digits) <= n);
+    isize  n_kernel = kernel_scratch_len(self);
+    DIGIT *buffer   = rawarray_new<DIGIT>(scratch, n + n_kernel);
+    internal_copy(buffer, cbegin(x.digits), len(x.digits));
+    internal_zero(buffer + len(x.digits), n - len(x.digits));
+    montgomery_sqr(self, buffer, buffer, buffer + n);
+    bigint_set_residue(dst, buffer, n);
+    rawarray_free(scratch, buffer, n + n_kernel);
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- EXPONENTIATION ----------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      Window size that minimizes multiplications for an exponent of `bits`
+ *      bits: a `k`-bit window costs `2^(k - 1)` products up front and saves
+ *      roughly `bits / (k + 1)` of them along the way.
+ */
+static int window_bits(isize bits)
+{
+    if (bits > 671) {
+        return 6;
+    } else if (bits > 239) {
+        return 5;
+    } else if (bits > 79) {
+        return 4;
+    } else if (bits > 23) {
+        return 3;
+    }
+    return 1;
+}
+
+static int exponent_bit(const BigInt &exp, isize i)
+{
+    return static_cast<int>((exp.digits[i / DIGIT_BITS] >> (i % DIGIT_BITS)) & 1);
+}
+
+/**
+ * @brief
+ *      Scratch digits for `montgomery_pow` with windows of up to `window` bits.
+ */
+static isize pow_scratch_len(const Montgomery &ctx, int window)
+{
+    isize n_table = static_cast<isize>(1) << (window - 1);
+    return (n_table + 1)*ctx.len + kernel_scratch_len(ctx);
+}
+
+/**
+ * @brief
+ *      Sets `dst[:n]` to `base^exp mod m`, out of Montgomery form, given `base`
+ *      in Montgomery form. `exp` must not be negative. `dst` may alias `base`.
+ *      Never allocates: everything lives in `scratch`, which must hold
+ *      `pow_scratch_len` digits for a window fitting `exp`.
+ */
+static void montgomery_pow(const Montgomery &ctx, DIGIT *dst, const DIGIT *base, const BigInt &exp, DIGIT *scratch)
+{
+    isize n    = ctx.len;
+    isize bits = bigint_bit_len(exp);
+    if (bits == 0) {
+        // 1, unless everything is 0 modulo 1.
+        bool is_one = (n == 1 && ctx.modulus[0] == 1);
+        internal_zero(dst, n);
+        dst[0] = is_one ? 0 : 1;
+        return;
+    }
+
+    // Odd powers `base^1, base^3, ..., base^(2^k - 1)` for the windows, then
+    // `base^2`, which is only needed to build the table.
+    int    window  = window_bits(bits);
+    isize  n_table = static_cast<isize>(1) << (window - 1);
+    DIGIT *table   = scratch;
+    DIGIT *square  = table + n_table*n;
+    DIGIT *kernel  = square + n;
+    DIGIT *acc     = dst;
+
+    internal_copy(table, base, n);
+    if (n_table > 1) {
+        montgomery_sqr(ctx, square, table, kernel);
+        for (isize i = 1; i < n_table; i++) {
+            montgomery_mul(ctx, table + i*n, table + (i - 1)*n, square, kernel);
+        }
+    }
+
+    // Left to right: runs of zeros cost a squaring per bit, everything else
+    // is consumed in windows of up to `window` bits that end in a 1.
+    bool  first = true;
+    isize i     = bits - 1;
+    while (i >= 0) {
+        if (exponent_bit(exp, i) == 0) {
+            montgomery_sqr(ctx, acc, acc, kernel);
+            i--;
+            continue;
+        }
+        isize low = (i - window + 1 > 0) ? i - window + 1 : 0;
+        while (exponent_bit(exp, low) == 0) {
+            low++;
+        }
+        isize value = 0;
+        for (isize j = i; j >= low; j--) {
+            value = 2*value + exponent_bit(exp, j);
+        }
+        const DIGIT *power = table + (value / 2)*n;
+        if (first) {
+            internal_copy(acc, power, n);
+            first = false;
+        } else {
+            for (isize j = low; j <= i; j++) {
+                montgomery_sqr(ctx, acc, acc, kernel);
+            }
+            montgomery_mul(ctx, acc, acc, power, kernel);
+        }
+        i = low - 1;
+    }
+
+    // Out of Montgomery form: reduce `acc` as a 2n-digit number.
+    DIGIT *t = kernel;
+    internal_copy(t, acc, n);
+    internal_zero(t + n, n);
+    montgomery_redc(ctx, acc, t);
+}
+
+bool bigint_modpow(BigInt *dst, const BigInt &base, const BigInt &exp, const Montgomery &ctx)
+{
+    return bigint_modpow(dst, base, exp, ctx, dst->digits.allocator);
+}
+
+bool bigint_modpow(BigInt *dst, const BigInt &base, const BigInt &exp, const Montgomery &ctx,
+    const Allocator &scratch)
+{
+    if (bigint_is_neg(exp)) {
+        return false;
+    }
+    isize  n        = ctx.len;
+    isize  n_buffer = n + pow_scratch_len(ctx, window_bits(bigint_bit_len(exp)));
+    DIGIT *buffer   = rawarray_new<DIGIT>(scratch, n_buffer);
+    DIGIT *residue  = buffer;
+    DIGIT *pow      = buffer + n;
+    montgomery_convert(ctx, residue, base, pow, scratch);
+    montgomery_pow(ctx, residue, residue, exp, pow);
+    bigint_set_residue(dst, residue, n);
+    rawarray_free(scratch, buffer, n_buffer);
+    return true;
+}
+
+bool bigint_modpow(BigInt *dst, const BigInt &base, const BigInt &exp, const BigInt &modulus)
+{
+    return bigint_modpow(dst, base, exp, modulus, dst->digits.allocator);
+}
+
+bool bigint_modpow(BigInt *dst, const BigInt &base, const BigInt &exp, const BigInt &modulus,
+    const Allocator &scratch)
+{
+    if (bigint_is_zero(modulus) || bigint_is_neg(exp)) {
+        return false;
+    }
+    Montgomery ctx;
+    if (montgomery_init(&ctx, modulus, scratch)) {
+        bool ok = bigint_modpow(dst, base, exp, ctx, scratch);
+        montgomery_free(&ctx);
+        return ok;
+    }
+
+    // Even modulus: plain left-to-right square and multiply, reducing as we
+    // go. Work on copies since `dst` may alias any of the inputs.
+    BigInt m      = bigint_make(scratch);
+    BigInt b      = bigint_make(scratch);
+    BigInt acc    = bigint_make(scratch);
+    BigInt square = bigint_make(scratch);
+    bigint_abs(&m, modulus);
+    bigint_mod(&b, base, m);
+    if (bigint_is_neg(b)) {
+        bigint_add(&b, b, m);
+    }
+    bigint_set_from_u64(&acc, 1, Sign::Positive);
+    for (isize i = bigint_bit_len(exp) - 1; i >= 0; i--) {
+        bigint_mul(&square, acc, acc, scratch);
+        bigint_divmod(nullptr, &acc, square, m, scratch);
+        if (exponent_bit(exp, i)) {
+            bigint_mul(&square, acc, b, scratch);
+            bigint_divmod(nullptr, &acc, square, m, scratch);
+        }
+    }
+    bigint_set(dst, acc);
+    bigint_free(&square);
+    bigint_free(&acc);
+    bigint_free(&b);
+    bigint_free(&m);
+    return true;
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- BATCHES ------------------------------------------------------------ {{{1
+
+/**
+ * @brief
+ *      Checks the exponents up front so that a bad one leaves all of `dst`
+ *      untouched.
+ *
+ * @return
+ *      The bit length of the longest exponent, or -1 if any is negative.
+ */
+static isize batch_max_exponent_bits(const Slice<BigInt> &exps)
+{
+    isize bits = 0;
+    for (isize i = 0; i < len(exps); i++) {
+        if (bigint_is_neg(exps[i])) {
+            return -1;
+        }
+        isize n_bits = bigint_bit_len(exps[i]);
+        if (n_bits > bits) {
+            bits = n_bits;
+        }
+    }
+    return bits;
+}
+
+bool bigint_modpow_batch(Slice<BigInt> dst, const Slice<BigInt> &bases, const Slice<BigInt> &exps,
+    const Montgomery &ctx)
+{
+    return bigint_modpow_batch(dst, bases, exps, ctx, parallel_hardware_threads(), heap_allocator);
+}
+
+bool bigint_modpow_batch(Slice<BigInt> dst, const Slice<BigInt> &bases, const Slice<BigInt> &exps,
+    const Montgomery &ctx, isize thread_count, const Allocator &scratch)
+{
+    assert(len(bases) == len(dst) && len(exps) == len(dst));
+    isize count = len(dst);
+    isize bits  = batch_max_exponent_bits(exps);
+    if (bits < 0) {
+        return false;
+    }
+    if (count == 0) {
+        return true;
+    }
+    // Small batches (few, short or narrow exponentiations) finish sooner than
+    // threads could be started, so they stay on this thread.
+    isize n    = ctx.len;
+    isize work = count * n * n * bits;
+    if (thread_count > work / MODPOW_BATCH_THREAD_WORK) {
+        thread_count = work / MODPOW_BATCH_THREAD_WORK;
+    }
+    if (thread_count > count) {
+        thread_count = count;
+    }
+    if (thread_count > PARALLEL_MAX_THREADS) {
+        thread_count = PARALLEL_MAX_THREADS;
+    }
+    if (thread_count < 1) {
+        thread_count = 1;
+    }
+
+    // All residues side by side, then one scratch area per worker, big enough
+    // for the widest window any exponent needs.
+    isize  align    = MODPOW_BATCH_WORKER_ALIGN;
+    isize  n_worker = (pow_scratch_len(ctx, window_bits(bits)) + align - 1) / align * align;
+    isize  n_buffer = count*n + thread_count*n_worker + align;
+    DIGIT *buffer   = rawarray_new<DIGIT>(scratch, n_buffer);
+    DIGIT *residues = buffer;
+    DIGIT *workers  = residues + count*n;
+    while (reinterpret_cast<std::uintptr_t>(workers) % (align * size_of(DIGIT)) != 0) {
+        workers++;
+    }
+
+    // Converting may divide, and so allocate from `scratch`, which only this
+    // thread may do. It is one product per base next to a whole exponent's
+    // worth in the workers.
+    for (isize i = 0; i < count; i++) {
+        montgomery_convert(ctx, residues + i*n, bases[i], workers, scratch);
+    }
+
+    // Exponents may differ in length, so workers claim small runs of the
+    // batch as they go instead of a fixed share each.
+    isize chunk = count / (4 * thread_count);
+    if (chunk < 1) {
+        chunk = 1;
+    }
+    std::atomic<isize> next{0};
+    run_parallel(thread_count, [&](isize worker) {
+        DIGIT *pow = workers + worker*n_worker;
+        for (;;) {
+            isize start = next.fetch_add(chunk, std::memory_order_relaxed);
+            if (start >= count) {
+                return;
+            }
+            isize stop = (start + chunk < count) ? start + chunk : count;
+            for (isize i = start; i < stop; i++) {
+                montgomery_pow(ctx, residues + i*n, residues + i*n, exps[i], pow);
+            }
+        }
+    });
+
+    // Only now touch `dst`, from this thread, as its allocators may require.
+    for (isize i = 0; i < count; i++) {
+        bigint_set_residue(&dst[i], residues + i*n, n);
+    }
+    rawarray_free(scratch, buffer, n_buffer);
+    return true;
+}
+
+bool bigint_modpow_batch(Slice<BigInt> dst, const Slice<BigInt> &bases, const Slice<BigInt> &exps,
+    const BigInt &modulus)
+{
+    return bigint_modpow_batch(dst, bases, exps, modulus, parallel_hardware_threads(), heap_allocator);
+}
+
+bool bigint_modpow_batch(Slice<BigInt> dst, const Slice<BigInt> &bases, const Slice<BigInt> &exps,
+    const BigInt &modulus, isize thread_count, const Allocator &scratch)
+{
+    assert(len(bases) == len(dst) && len(exps) == len(dst));
+    if (bigint_is_zero(modulus) || batch_max_exponent_bits(exps) < 0) {
+        return false;
+    }
+    Montgomery ctx;
+    if (montgomery_init(&ctx, modulus, scratch)) {
+        bool ok = bigint_modpow_batch(dst, bases, exps, ctx, thread_count, scratch);
+        montgomery_free(&ctx);
+        return ok;
+    }
+    for (isize i = 0; i < len(dst); i++) {
+        bigint_modpow(&dst[i], bases[i], exps[i], modulus, scratch);
+    }
+    return true;
+}
+
+///--- 1}}} --------------------------------------------------------------------
@@ -0,0 +1,402 @@
+#include "bigint_internal.hpp"
+
+/**
+ * @brief
+ *      Subquadratic multiplication. Everything here works on raw digit
+ *      buffers; `internal_mul` and `internal_sqr` are the only entry points. The NTT lives in
+ *      `bigint_ntt.cpp`.
+ *
+ * @note
+ *      All temporaries for the whole recursion are carved out of one scratch
+ *      buffer, allocated once per top-level call from the caller's allocator.
+ */
+
+isize bigint_karatsuba_threshold     = BIGINT_KARATSUBA_THRESHOLD;
+isize bigint_sqr_karatsuba_threshold = BIGINT_SQR_KARATSUBA_THRESHOLD;
+isize bigint_toom3_threshold         = BIGINT_TOOM3_THRESHOLD;
+
+static void mul_any(DIGIT *dst, const DIGIT *x, isize x_len, const DIGIT *y, isize y_len, DIGIT *scratch);
+
+///--- HELPERS ----------------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      Toom-3 interpolation goes through negative intermediates. Rather than
+ *      tracking signs, we do the arithmetic modulo 2^(64 * width), which is
+ *      safe as long as `width` has a couple of digits of headroom over the
+ *      largest magnitude involved.
+ */
+
+static void tc_negate(DIGIT *x, isize width)
+{
+    for (isize i = 0; i < width; i++) {
+        x[i] = ~x[i];
+    }
+    internal_add_digit(x, x, width, 1);
+}
+
+// Arithmetic shift right by 1. Only used for exact halving.
+static void tc_halve(DIGIT *x, isize width)
+{
+    for (isize i = 0; i < width - 1; i++) {
+        x[i] = (x[i] >> 1) | (x[i + 1] << (DIGIT_BITS - 1));
+    }
+    x[width - 1] = static_cast<DIGIT>(static_cast<i64>(x[width - 1]) >> 1);
+}
+
+/**
+ * @brief
+ *      Exact division by 3 via multiplication by its inverse mod 2^64 (Hensel
+ *      division), so there is no actual division instruction involved.
+ */
+static void tc_divexact_3(DIGIT *x, isize width)
+{
+    const DIGIT inverse = 0xAAAAAAAAAAAAAAABull; // 3 * inverse == 1 (mod 2^64)
+    DIGIT       borrow  = 0;
+    for (isize i = 0; i < width; i++) {
+        DIGIT value  = x[i];
+        DIGIT diff   = value - borrow;
+        borrow       = (diff > value);
+        DIGIT quot   = diff * inverse;
+        x[i]         = quot;
+        DIGIT upper;
+        internal_mul_wide(quot, 3, &upper);
+        borrow      += upper;
+    }
+}
+
+/**
+ * @brief
+ *      Writes `|x - y|` to `dst[:dst_len]`, zero-padded. Returns true if the
+ *      difference was negative, i.e. `x < y`.
+ */
+static bool sub_abs(DIGIT *dst, isize dst_len, const DIGIT *x, isize x_len, const DIGIT *y, isize y_len)
+{
+    x_len = internal_normalize(x, x_len);
+    y_len = internal_normalize(y, y_len);
+    bool neg = internal_cmp(x, x_len, y, y_len) == Comparison::Less;
+    if (neg) {
+        internal_sub(dst, y, y_len, x, x_len);
+        internal_zero(dst + y_len, dst_len - y_len);
+    } else {
+        internal_sub(dst, x, x_len, y, y_len);
+        internal_zero(dst + x_len, dst_len - x_len);
+    }
+    return neg;
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- KARATSUBA ---------------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      Subtractive Karatsuba. With `x = x1*B^m + x0` and `y = y1*B^m + y0`:
+ *
+ *          x*y = z2*B^2m + (z0 + z2 + (x0 - x1)(y1 - y0))*B^m + z0
+ *
+ *      where `z0 = x0*y0` and `z2 = x1*y1`. Using differences rather than sums
+ *      keeps the middle operands at `m` digits, at the cost of a sign.
+ *
+ * @note
+ *      Assumes `x_len >= y_len > ceil(x_len / 2)`.
+ */
+static void mul_karatsuba(DIGIT *dst, const DIGIT *x, isize x_len, const DIGIT *y, isize y_len, DIGIT *scratch)
+{
+    isize m      = (x_len + 1) / 2;
+    isize x1_len = x_len - m;
+    isize y1_len = y_len - m;
+    assert(y1_len > 0);
+
+    DIGIT *x_diff = scratch;
+    DIGIT *y_diff = x_diff + m;
+    DIGIT *middle = y_diff + m;     // 2*m + 1 digits
+    DIGIT *next   = middle + 2*m + 1;
+
+    bool x_neg = sub_abs(x_diff, m, x, m, x + m, x1_len);
+    bool y_neg = sub_abs(y_diff, m, y + m, y1_len, y, m);
+
+    // z0 and z2 go straight into their final positions.
+    mul_any(dst, x, m, y, m, next);
+    mul_any(dst + 2*m, x + m, x1_len, y + m, y1_len, next);
+
+    // middle = z0 + z2
+    internal_copy(middle, dst, 2*m);
+    middle[2*m] = internal_add(middle, middle, 2*m, dst + 2*m, x1_len + y1_len);
+
+    // middle +/-= |x0 - x1| * |y1 - y0|, which we can now write over `next`.
+    DIGIT *product = next;
+    DIGIT *rest    = product + 2*m;
+    mul_any(product, x_diff, m, y_diff, m, rest);
+    if (x_neg == y_neg) {
+        internal_add(middle, middle, 2*m + 1, product, 2*m);
+    } else {
+        internal_sub(middle, middle, 2*m + 1, product, 2*m);
+    }
+
+    DIGIT carry = internal_add(dst + m, dst + m, x_len + y_len - m, middle, internal_normalize(middle, 2*m + 1));
+    assert(carry == 0);
+    unused(carry);
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- TOOM-3 ------------------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      Writes `x0 + x1 + x2` to `sum` and `|x0 - x1 + x2|` to `diff`, each
+ *      `k + 1` digits. Returns true if the latter was negative.
+ */
+static bool toom3_eval_pm1(DIGIT *sum, DIGIT *diff, const DIGIT *x, isize k, isize x2_len)
+{
+    // x0 + x2
+    sum[k] = internal_add(sum, x, k, x + 2*k, x2_len);
+    bool neg = sub_abs(diff, k + 1, sum, k + 1, x + k, k);
+    internal_add(sum, sum, k + 1, x + k, k);
+    return neg;
+}
+
+/**
+ * @brief
+ *      Writes `x0 + 2*x1 + 4*x2` to `out`, which is `k + 1` digits.
+ */
+static void toom3_eval_2(DIGIT *out, const DIGIT *x, isize k, isize x2_len)
+{
+    internal_copy(out, x, k);
+    out[k]  = 0;
+    out[k] += internal_mul_add_digit(out, x + k, k, 2);
+    DIGIT carry = internal_mul_add_digit(out, x + 2*k, x2_len, 4);
+    internal_add_digit(out + x2_len, out + x2_len, k + 1 - x2_len, carry);
+}
+
+/**
+ * @brief
+ *      Computes `x * y` into a `width`-digit two's complement buffer `out`.
+ */
+static void toom3_point(DIGIT *out, isize width, const DIGIT *x, const DIGIT *y, isize len, bool neg, DIGIT *scratch)
+{
+    isize x_len = internal_normalize(x, len);
+    isize y_len = internal_normalize(y, len);
+    internal_zero(out, width);
+    if (x_len == 0 || y_len == 0) {
+        return;
+    }
+    mul_any(out, x, x_len, y, y_len, scratch);
+    if (neg) {
+        tc_negate(out, width);
+    }
+}
+
+/**
+ * @brief
+ *      Toom-Cook 3-way. Splits both operands into 3 pieces of `k` digits,
+ *      treats them as quadratic polynomials in `B^k`, evaluates at
+ *      `0, 1, -1, 2, inf`, multiplies pointwise then interpolates the 5
+ *      coefficients of the product (Bodrato's sequence).
+ *
+ * @note
+ *      Assumes `x_len >= y_len > 2*ceil(x_len / 3)`.
+ */
+static void mul_toom3(DIGIT *dst, const DIGIT *x, isize x_len, const DIGIT *y, isize y_len, DIGIT *scratch)
+{
+    isize k      = (x_len + 2) / 3;
+    isize x2_len = x_len - 2*k;
+    isize y2_len = y_len - 2*k;
+    isize width  = 2*k + 4;
+    assert(y2_len > 0);
+
+    DIGIT *x_eval  = scratch;                 // 3 * (k + 1) digits
+    DIGIT *y_eval  = x_eval + 3*(k + 1);      // 3 * (k + 1) digits
+    DIGIT *v1      = y_eval + 3*(k + 1);      // width digits each
+    DIGIT *vm1     = v1 + width;
+    DIGIT *v2      = vm1 + width;
+    DIGIT *tmp     = v2 + width;
+    DIGIT *next    = tmp + width;
+
+    DIGIT *x1 = x_eval, *xm1 = x1 + (k + 1), *x2 = xm1 + (k + 1);
+    DIGIT *y1 = y_eval, *ym1 = y1 + (k + 1), *y2 = ym1 + (k + 1);
+
+    bool xm1_neg = toom3_eval_pm1(x1, xm1, x, k, x2_len);
+    bool ym1_neg = toom3_eval_pm1(y1, ym1, y, k, y2_len);
+    toom3_eval_2(x2, x, k, x2_len);
+    toom3_eval_2(y2, y, k, y2_len);
+
+    toom3_point(v1, width, x1, y1, k + 1, false, next);
+    toom3_point(vm1, width, xm1, ym1, k + 1, xm1_neg != ym1_neg, next);
+    toom3_point(v2, width, x2, y2, k + 1, false, next);
+
+    // v0 and vinf go straight to their final positions.
+    DIGIT *v0   = dst;
+    DIGIT *vinf = dst + 4*k;
+    isize  vinf_len = x2_len + y2_len;
+    mul_any(v0, x, k, y, k, next);
+    mul_any(vinf, x + 2*k, x2_len, y + 2*k, y2_len, next);
+
+    /**
+     * @brief
+     *      Interpolation. With `p(t) = c0 + c1*t + c2*t^2 + c3*t^3 + c4*t^4`:
+     *
+     *          v2   = (v2 - vm1) / 3       -> c1 + c2 + 3*c3 + 5*c4
+     *          v1   = (v1 - vm1) / 2       -> c1 + c3
+     *          vm1  = vm1 - v0             -> -c1 + c2 - c3 + c4
+     *          v2   = (v2 - vm1) / 2       -> c1 + 2*c3 + 2*c4
+     *          v2   = v2 - 2*vinf          -> c1 + 2*c3
+     *          vm1  = vm1 + v1 - vinf      -> c2
+     *          v2   = v2 - v1              -> c3
+     *          v1   = v1 - v2              -> c1
+     */
+    internal_sub(v2, v2, vm1, width);
+    tc_divexact_3(v2, width);
+
+    internal_sub(v1, v1, vm1, width);
+    tc_halve(v1, width);
+
+    internal_sub(vm1, vm1, width, v0, 2*k);
+
+    internal_sub(v2, v2, vm1, width);
+    tc_halve(v2, width);
+
+    internal_zero(tmp, width);
+    tmp[vinf_len] = internal_mul_digit(tmp, vinf, vinf_len, 2);
+    internal_sub(v2, v2, tmp, width);
+
+    internal_add(vm1, vm1, v1, width);
+    internal_sub(vm1, vm1, width, vinf, vinf_len);
+
+    internal_sub(v2, v2, v1, width);
+    internal_sub(v1, v1, v2, width);
+
+    // Recomposition: the gap between v0 and vinf is still unwritten.
+    isize total = x_len + y_len;
+    internal_zero(dst + 2*k, 2*k);
+    DIGIT *coeffs[] = {v1, vm1, v2};
+    for (isize i = 0; i < 3; i++) {
+        isize  offset = (i + 1) * k;
+        isize  c_len  = internal_normalize(coeffs[i], width);
+        DIGIT  carry  = internal_add(dst + offset, dst + offset, total - offset, coeffs[i], c_len);
+        assert(carry == 0);
+        unused(carry);
+    }
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- DISPATCH ----------------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      Upper bound on the scratch digits needed to multiply operands of at
+ *      most `len` digits. Deliberately loose but linear in `len`.
+ */
+static isize mul_scratch_len(isize len)
+{
+    isize total = 0;
+    while (len >= bigint_karatsuba_threshold && len > 1) {
+        // Toom-3 needs the most at any one level: ~14*ceil(len / 3) + 22.
+        total += 6*len + 40;
+        // Largest sub-product: Karatsuba halves, Toom-3 (which needs at least
+        // 3 digits) recurses on k + 1.
+        isize half  = (len + 1) / 2;
+        isize third = (len >= 3) ? (len + 2) / 3 + 1 : 0;
+        len = (half > third) ? half : third;
+    }
+    return total;
+}
+
+/**
+ * @brief
+ *      `x_len` is much greater than `y_len`: multiply `y` by `y_len`-sized
+ *      chunks of `x` so each sub-product is balanced, accumulating into `dst`.
+ */
+static void mul_unbalanced(DIGIT *dst, const DIGIT *x, isize x_len, const DIGIT *y, isize y_len, DIGIT *scratch)
+{
+    DIGIT *product = scratch;
+    DIGIT *next    = product + 2*y_len;
+
+    mul_any(dst, x, y_len, y, y_len, next);
+    isize done = y_len;
+    while (done < x_len) {
+        isize chunk = x_len - done;
+        if (chunk > y_len) {
+            chunk = y_len;
+        }
+        mul_any(product, y, y_len, x + done, chunk, next);
+        // dst[done:done + y_len] holds the previous carry-over, the rest is new.
+        internal_copy(dst + y_len + done, product + y_len, chunk);
+        DIGIT carry = internal_add(dst + done, dst + done, y_len, product, y_len);
+        internal_add_digit(dst + done + y_len, dst + done + y_len, chunk, carry);
+        done += chunk;
+    }
+}
+
+/**
+ * @brief
+ *      Sets `dst[:x_len + y_len]` to `x * y` for any operand order and sizes,
+ *      including zero-length operands.
+ */
+static void mul_any(DIGIT *dst, const DIGIT *x, isize x_len, const DIGIT *y, isize y_len, DIGIT *scratch)
+{
+    if (x_len < y_len) {
+        const DIGIT *tmp_ptr = x;
+        isize        tmp_len = x_len;
+        x     = y;
+        x_len = y_len;
+        y     = tmp_ptr;
+        y_len = tmp_len;
+    }
+    if (y_len == 0) {
+        internal_zero(dst, x_len);
+        return;
+    }
+    if (y_len < bigint_karatsuba_threshold) {
+        internal_mul_basecase(dst, x, x_len, y, y_len);
+    } else if (y_len >= bigint_ntt_threshold) {
+        internal_mul_ntt(dst, x, x_len, y, y_len, scratch);
+    } else if (y_len >= bigint_toom3_threshold && y_len > 2*((x_len + 2) / 3)) {
+        mul_toom3(dst, x, x_len, y, y_len, scratch);
+    } else if (y_len > (x_len + 1) / 2) {
+        mul_karatsuba(dst, x, x_len, y, y_len, scratch);
+    } else {
+        mul_unbalanced(dst, x, x_len, y, y_len, scratch);
+    }
+}
+
+isize internal_mul_scratch_len(isize x_len, isize y_len)
+{
+    // Only the top level can go to the NTT: every recursive sub-product is
+    // shorter than the shorter operand.
+    if (x_len >= bigint_ntt_threshold && y_len >= bigint_ntt_threshold) {
+        return internal_mul_ntt_scratch_len(x_len, y_len);
+    }
+    return mul_scratch_len((x_len > y_len) ? x_len : y_len);
+}
+
+void internal_mul(DIGIT *dst, const DIGIT *x, isize x_len, const DIGIT *y, isize y_len, const Allocator &scratch)
+{
+    isize  n_scratch = internal_mul_scratch_len(x_len, y_len);
+    DIGIT *buffer    = nullptr;
+    if (n_scratch > 0) {
+        buffer = rawarray_new<DIGIT>(scratch, n_scratch);
+    }
+    mul_any(dst, x, x_len, y, y_len, buffer);
+    if (buffer) {
+        rawarray_free(scratch, buffer, n_scratch);
+    }
+}
+
+void internal_mul(DIGIT *dst, const DIGIT *x, isize x_len, const DIGIT *y, isize y_len, DIGIT *scratch)
+{
+    mul_any(dst, x, x_len, y, y_len, scratch);
+}
+
+void internal_sqr(DIGIT *dst, const DIGIT *x, isize len, DIGIT *scratch)
+{
+    if (len < bigint_sqr_karatsuba_threshold) {
+        internal_sqr_basecase(dst, x, len);
+    } else {
+        mul_any(dst, x, len, x, len, scratch);
+    }
+}
+
+///--- 1}}} --------------------------------------------------------------------
@@ -0,0 +1,358 @@
+#include "bigint_internal.hpp"
+
+/**
+ * @brief
+ *      Multiplication via the number-theoretic transform (NTT), i.e. an FFT
+ *      over the integers modulo a prime rather than over the complex numbers.
+ *      Everything is exact, so results are bit-identical to long
+ *      multiplication.
+ *
+ * @note
+ *      Each 64-bit digit is used as a coefficient as-is. A coefficient of the
+ *      convolution is less than `min(x_len, y_len) * 2^128`, so we compute the
+ *      convolution modulo 3 primes of ~62 bits each (~2^184 combined), then
+ *      recover the exact coefficients with the Chinese Remainder Theorem.
+ *
+ * @link
+ *      https://cp-algorithms.com/algebra/fft.html#number-theoretic-transform
+ */
+
+isize bigint_ntt_threshold = BIGINT_NTT_THRESHOLD;
+
+/**
+ * @brief
+ *      Transforms of at most this many digits (32 KiB) are done breadth-first
+ *      since they fit in cache. Larger ones are split depth-first so that each
+ *      half is finished, while still hot, before moving on to the other.
+ */
+#define NTT_BLOCK_LEN   4096
+
+///--- MONTGOMERY ARITHMETIC ---------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      A prime of the form `c * 2^k + 1` and what we need for Montgomery
+ *      multiplication modulo it, with `R = 2^64`.
+ */
+struct Ntt_Prime {
+    DIGIT p;
+    DIGIT p_neg_inv; // -p^-1 mod R
+    DIGIT r2;        // R^2 mod p
+    DIGIT generator; // Primitive root modulo p.
+    int   two_adicity;
+};
+
+// Listed in decreasing order; note that `p1 < 2 * p3`. The CRT relies on it.
+static const DIGIT NTT_PRIMES[3][3] = {
+    // p,                    generator, two-adicity
+    {0x3a00000000000001ull, 3, 57},
+    {0x2c40000000000001ull, 7, 54},
+    {0x2280000000000001ull, 5, 55},
+};
+
+static DIGIT mont_reduce(DIGIT lower, DIGIT upper, const Ntt_Prime &m)
+{
+    // Add a multiple of p so the lower half becomes 0, then divide by R.
+    DIGIT q = lower * m.p_neg_inv;
+    DIGIT qp_upper;
+    DIGIT qp_lower = internal_mul_wide(q, m.p, &qp_upper);
+    DIGIT sum      = lower + qp_lower;
+    DIGIT out      = upper + qp_upper + (sum < lower);
+    return (out >= m.p) ? out - m.p : out;
+}
+
+static DIGIT mont_mul(DIGIT x, DIGIT y, const Ntt_Prime &m)
+{
+    DIGIT upper;
+    DIGIT lower = internal_mul_wide(x, y, &upper);
+    return mont_reduce(lower, upper, m);
+}
+
+static DIGIT mod_add(DIGIT x, DIGIT y, const Ntt_Prime &m)
+{
+    DIGIT sum = x + y;
+    return (sum >= m.p) ? sum - m.p : sum;
+}
+
+static DIGIT mod_sub(DIGIT x, DIGIT y, const Ntt_Prime &m)
+{
+    return (x >= y) ? x - y : x + m.p - y;
+}
+
+static DIGIT mont_from(DIGIT x, const Ntt_Prime &m)
+{
+    return mont_mul(x, m.r2, m);
+}
+
+static DIGIT mont_pow(DIGIT base, DIGIT exponent, const Ntt_Prime &m)
+{
+    DIGIT result = mont_from(1, m);
+    while (exponent != 0) {
+        if (exponent & 1) {
+            result = mont_mul(result, base, m);
+        }
+        base       = mont_mul(base, base, m);
+        exponent >>= 1;
+    }
+    return result;
+}
+
+static Ntt_Prime ntt_prime_make(const DIGIT (&params)[3])
+{
+    Ntt_Prime m;
+    m.p           = params[0];
+    m.generator   = params[1];
+    m.two_adicity = static_cast<int>(params[2]);
+
+    // Newton's iteration doubles the correct low bits each step: 1, 2, 4, ...
+    DIGIT inv = 1;
+    for (int i = 0; i < 6; i++) {
+        inv *= 2 - m.p * inv;
+    }
+    m.p_neg_inv = 0 - inv;
+
+    // R mod p, doubled 64 more times to get R^2 mod p.
+    DIGIT r = (0 - m.p) % m.p;
+    for (int i = 0; i < DIGIT_BITS; i++) {
+        r = (r >= m.p - r) ? r - (m.p - r) : r + r;
+    }
+    m.r2 = r;
+    return m;
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- TRANSFORMS --------------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      Fills `roots[half:2*half]` with `w^0, w^1, ..., w^(half - 1)` for every
+ *      power of 2 `half < n`, where `w` is a primitive `2*half`-th root of
+ *      unity. Index 0 is unused. Values are in Montgomery form.
+ */
+static void ntt_roots_init(DIGIT *roots, isize n, bool inverse, const Ntt_Prime &m)
+{
+    DIGIT order_exp = (m.p - 1) / static_cast<DIGIT>(n);
+    DIGIT w         = mont_pow(mont_from(m.generator, m), order_exp, m);
+    if (inverse) {
+        w = mont_pow(w, m.p - 2, m);
+    }
+    isize half = n / 2;
+    roots[half] = mont_from(1, m);
+    for (isize j = 1; j < half; j++) {
+        roots[half + j] = mont_mul(roots[half + j - 1], w, m);
+    }
+    // w_m^j == w_2m^2j, so each smaller level is every other root of the next.
+    for (half /= 2; half >= 1; half /= 2) {
+        for (isize j = 0; j < half; j++) {
+            roots[half + j] = roots[2*half + 2*j];
+        }
+    }
+}
+
+/**
+ * @brief
+ *      Forward transform (decimation in frequency). Natural order in,
+ *      bit-reversed order out.
+ */
+static void ntt_forward(DIGIT *a, isize n, const DIGIT *roots, const Ntt_Prime &m)
+{
+    if (n > NTT_BLOCK_LEN) {
+        isize        half = n / 2;
+        const DIGIT *w    = roots + half;
+        for (isize j = 0; j < half; j++) {
+            DIGIT u     = a[j];
+            DIGIT v     = a[j + half];
+            a[j]        = mod_add(u, v, m);
+            a[j + half] = mont_mul(mod_sub(u, v, m), w[j], m);
+        }
+        ntt_forward(a, half, roots, m);
+        ntt_forward(a + half, half, roots, m);
+        return;
+    }
+    for (isize half = n / 2; half >= 1; half /= 2) {
+        const DIGIT *w = roots + half;
+        for (isize start = 0; start < n; start += 2*half) {
+            DIGIT *lo = a + start;
+            DIGIT *hi = lo + half;
+            for (isize j = 0; j < half; j++) {
+                DIGIT u = lo[j];
+                DIGIT v = hi[j];
+                lo[j]   = mod_add(u, v, m);
+                hi[j]   = mont_mul(mod_sub(u, v, m), w[j], m);
+            }
+        }
+    }
+}
+
+/**
+ * @brief
+ *      Inverse transform (decimation in time), minus the final `1/n` scaling.
+ *      Bit-reversed order in, natural order out, so no explicit bit-reversal
+ *      permutation is ever needed.
+ */
+static void ntt_inverse(DIGIT *a, isize n, const DIGIT *roots, const Ntt_Prime &m)
+{
+    if (n > NTT_BLOCK_LEN) {
+        isize        half = n / 2;
+        const DIGIT *w    = roots + half;
+        ntt_inverse(a, half, roots, m);
+        ntt_inverse(a + half, half, roots, m);
+        for (isize j = 0; j < half; j++) {
+            DIGIT u     = a[j];
+            DIGIT v     = mont_mul(a[j + half], w[j], m);
+            a[j]        = mod_add(u, v, m);
+            a[j + half] = mod_sub(u, v, m);
+        }
+        return;
+    }
+    for (isize half = 1; half < n; half *= 2) {
+        const DIGIT *w = roots + half;
+        for (isize start = 0; start < n; start += 2*half) {
+            DIGIT *lo = a + start;
+            DIGIT *hi = lo + half;
+            for (isize j = 0; j < half; j++) {
+                DIGIT u = lo[j];
+                DIGIT v = mont_mul(hi[j], w[j], m);
+                lo[j]   = mod_add(u, v, m);
+                hi[j]   = mod_sub(u, v, m);
+            }
+        }
+    }
+}
+
+/**
+ * @brief
+ *      Writes the cyclic convolution of `x` and `y`, modulo `m.p`, to `out`.
+ *      Each resulting coefficient is in normal (not Montgomery) form.
+ *
+ * @note
+ *      `out` and `tmp` are `n` digits each; `roots` is `2 * n` digits.
+ */
+static void ntt_convolve(DIGIT *out, DIGIT *tmp, DIGIT *roots, isize n,
+    const DIGIT *x, isize x_len, const DIGIT *y, isize y_len, const Ntt_Prime &m)
+{
+    DIGIT *forward = roots;
+    DIGIT *inverse = roots + n;
+    ntt_roots_init(forward, n, false, m);
+    ntt_roots_init(inverse, n, true, m);
+
+    for (isize i = 0; i < x_len; i++) {
+        out[i] = mont_from(x[i], m);
+    }
+    internal_zero(out + x_len, n - x_len);
+    ntt_forward(out, n, forward, m);
+
+    // Squaring needs only the one forward transform.
+    if (x == y && x_len == y_len) {
+        for (isize i = 0; i < n; i++) {
+            out[i] = mont_mul(out[i], out[i], m);
+        }
+    } else {
+        for (isize i = 0; i < y_len; i++) {
+            tmp[i] = mont_from(y[i], m);
+        }
+        internal_zero(tmp + y_len, n - y_len);
+        ntt_forward(tmp, n, forward, m);
+        for (isize i = 0; i < n; i++) {
+            out[i] = mont_mul(out[i], tmp[i], m);
+        }
+    }
+    ntt_inverse(out, n, inverse, m);
+
+    // 1/n == -(p - 1)/n (mod p). Multiplying a Montgomery form value by a
+    // normal one both scales and converts out of Montgomery form.
+    DIGIT scale = m.p - (m.p - 1) / static_cast<DIGIT>(n);
+    for (isize i = 0; i < n; i++) {
+        out[i] = mont_mul(out[i], scale, m);
+    }
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- ENTRY POINT -------------------------------------------------------- {{{1
+
+static isize ntt_len(isize x_len, isize y_len)
+{
+    return math_next_power_of_2(x_len + y_len);
+}
+
+isize internal_mul_ntt_scratch_len(isize x_len, isize y_len)
+{
+    // 3 residues, 1 temporary and forward/inverse roots.
+    return 6 * ntt_len(x_len, y_len);
+}
+
+void internal_mul_ntt(DIGIT *dst, const DIGIT *x, isize x_len, const DIGIT *y, isize y_len, DIGIT *scratch)
+{
+    isize n = ntt_len(x_len, y_len);
+
+    Ntt_Prime primes[3];
+    for (isize i = 0; i < 3; i++) {
+        primes[i] = ntt_prime_make(NTT_PRIMES[i]);
+        assert(n <= (static_cast<isize>(1) << primes[i].two_adicity));
+    }
+    // 2^184 / 2^128: no coefficient of the convolution may reach p1*p2*p3.
+    assert(((x_len < y_len) ? x_len : y_len) < (static_cast<isize>(1) << 55));
+
+    DIGIT *residues[3] = {scratch, scratch + n, scratch + 2*n};
+    DIGIT *tmp         = scratch + 3*n;
+    DIGIT *roots       = scratch + 4*n;
+    for (isize i = 0; i < 3; i++) {
+        ntt_convolve(residues[i], tmp, roots, n, x, x_len, y, y_len, primes[i]);
+    }
+
+    /**
+     * @brief
+     *      Garner's algorithm. Each coefficient is
+     *
+     *          c = v1 + v2*p1 + v3*p1*p2
+     *
+     *      with `v1 < p1`, `v2 < p2`, `v3 < p3`, so it needs 3 digits. We carry
+     *      the (at most 3-digit) overflow into the next coefficient.
+     */
+    const Ntt_Prime &m1 = primes[0];
+    const Ntt_Prime &m2 = primes[1];
+    const Ntt_Prime &m3 = primes[2];
+
+    // Constants in Montgomery form, so multiplying a normal form value by one
+    // yields a normal form result.
+    DIGIT inv_p1_mod_p2 = mont_pow(mont_from(m1.p - m2.p, m2), m2.p - 2, m2);
+    DIGIT inv_p1_mod_p3 = mont_pow(mont_from(m1.p - m3.p, m3), m3.p - 2, m3);
+    DIGIT inv_p2_mod_p3 = mont_pow(mont_from(m2.p - m3.p, m3), m3.p - 2, m3);
+    DIGIT p12[2];
+    p12[0] = internal_mul_wide(m1.p, m2.p, &p12[1]);
+
+    DIGIT carry[3] = {0, 0, 0};
+    isize out_len  = x_len + y_len;
+    for (isize i = 0; i < out_len; i++) {
+        DIGIT r1 = residues[0][i];
+        DIGIT r2 = residues[1][i];
+        DIGIT r3 = residues[2][i];
+
+        DIGIT r1_mod_p2 = (r1 >= m2.p) ? r1 - m2.p : r1;
+        DIGIT r1_mod_p3 = (r1 >= m3.p) ? r1 - m3.p : r1;
+        DIGIT v2        = mont_mul(mod_sub(r2, r1_mod_p2, m2), inv_p1_mod_p2, m2);
+        DIGIT v2_mod_p3 = (v2 >= m3.p) ? v2 - m3.p : v2;
+        DIGIT v3        = mont_mul(mod_sub(r3, r1_mod_p3, m3), inv_p1_mod_p3, m3);
+        v3              = mont_mul(mod_sub(v3, v2_mod_p3, m3), inv_p2_mod_p3, m3);
+
+        // value = v1 + v2*p1 + v3*(p1*p2), as 3 digits.
+        DIGIT value[3];
+        DIGIT term[3];
+        value[0] = internal_mul_wide(v2, m1.p, &value[1]);
+        value[2] = 0;
+        term[2]  = internal_mul_digit(term, p12, 2, v3);
+        internal_add(value, value, term, 3);
+        internal_add_digit(value, value, 3, r1);
+
+        internal_add(carry, carry, value, 3);
+        dst[i]   = carry[0];
+        carry[0] = carry[1];
+        carry[1] = carry[2];
+        carry[2] = 0;
+    }
+    assert(carry[0] == 0 && carry[1] == 0);
+}
+
+///--- 1}}} --------------------------------------------------------------------
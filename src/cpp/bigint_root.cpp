@@ -0,0 +1,508 @@
+#include "bigint.hpp"
+#include "bigint_internal.hpp"
+
+#include <cmath>
+
+/**
+ * @brief
+ *      Integer roots by Newton's method with precision doubling. The root of
+ *      the leading half of the bits, found recursively, is already good to
+ *      half the bits of the full one, so a step or two at full size finish
+ *      it. Those steps dominate, which puts the total at a small multiple of
+ *      one full-size multiplication rather than one per bit of the root.
+ *
+ * @link
+ *      https://github.com/python/cpython/blob/main/Modules/mathmodule.c
+ *      (`math_isqrt`, for the square root recursion and its proof).
+ *      R. Brent and P. Zimmermann, Modern Computer Arithmetic, Section 1.5.
+ */
+
+// Roots of up to this many bits come from floating point, which gets them to
+// within one, and are then fixed up exactly.
+#define ROOT_ESTIMATE_BITS  32
+
+// Exponents whose residue tests share one division of the candidate.
+#define POWER_TEST_BLOCK    64
+
+// Odd primes whose product still fits in a digit, for residue tests.
+static const DIGIT SMALL_PRIMES[] = {3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47};
+
+///--- WORDS -------------------------------------------------------------- {{{1
+
+static int isize_bit_len(isize x)
+{
+    return (x == 0) ? 0 : DIGIT_BITS - internal_count_leading_zeros(static_cast<DIGIT>(x));
+}
+
+/**
+ * @brief
+ *      `x^n mod 2^64`.
+ */
+static DIGIT pow_wrap(DIGIT x, isize n)
+{
+    DIGIT result = 1;
+    for (; n > 0; n >>= 1) {
+        if (n & 1) {
+            result *= x;
+        }
+        x *= x;
+    }
+    return result;
+}
+
+/**
+ * @brief
+ *      `x^e mod q`. Assumes `q < 2^32`, so products fit in a digit.
+ */
+static DIGIT pow_mod(DIGIT x, DIGIT e, DIGIT q)
+{
+    DIGIT result = 1;
+    x %= q;
+    for (; e > 0; e >>= 1) {
+        if (e & 1) {
+            result = result * x % q;
+        }
+        x = x * x % q;
+    }
+    return result;
+}
+
+static bool is_small_prime(DIGIT q)
+{
+    if (q < 4) {
+        return q >= 2;
+    } else if (q % 2 == 0 || q % 3 == 0) {
+        return false;
+    }
+    for (DIGIT d = 5; d * d <= q; d += 6) {
+        if (q % d == 0 || q % (d + 2) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief
+ *      Whether `r` is an `n`th power modulo the prime `q`, for `n` dividing
+ *      `q - 1`. By Euler's criterion, the nonzero ones are those sent to 1 by
+ *      raising to `(q - 1) / n`.
+ */
+static bool is_power_residue(DIGIT r, DIGIT q, isize n)
+{
+    r %= q;
+    return r == 0 || pow_mod(r, (q - 1) / static_cast<DIGIT>(n), q) == 1;
+}
+
+/**
+ * @brief
+ *      Whether the low digit of a square could be `x`: past the trailing
+ *      zeros, of which there are an even number, an odd square is 1 mod 8.
+ */
+static bool is_square_low_digit(DIGIT x)
+{
+    if (x == 0) {
+        return true;
+    }
+    int zeros = internal_count_trailing_zeros(x);
+    return zeros % 2 == 0 && ((x >> zeros) & 7) == 1;
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- HELPERS ------------------------------------------------------------ {{{1
+
+/**
+ * @brief
+ *      `log2(x)` for `x > 0`, from the leading digit's worth of bits.
+ */
+static double bigint_log2(const BigInt &x)
+{
+    isize bits  = bigint_bit_len(x);
+    isize shift = (bits > DIGIT_BITS) ? bits - DIGIT_BITS : 0;
+    isize index = shift / DIGIT_BITS;
+    int   bit   = static_cast<int>(shift % DIGIT_BITS);
+    DIGIT top   = x.digits[index] >> bit;
+    if (bit > 0 && index + 1 < len(x.digits)) {
+        top |= x.digits[index + 1] << (DIGIT_BITS - bit);
+    }
+    return std::log2(static_cast<double>(top)) + static_cast<double>(shift);
+}
+
+/**
+ * @brief
+ *      `dst = x^n` for `n >= 1`, from the top bit of `n` down. `dst` and `tmp`
+ *      may not alias `x`.
+ */
+static void bigint_pow(BigInt *dst, const BigInt &x, isize n, BigInt *tmp, const Allocator &scratch)
+{
+    bigint_set(dst, x);
+    for (int bit = isize_bit_len(n) - 2; bit >= 0; bit--) {
+        internal_bigint_sqr(tmp, *dst, scratch);
+        if ((n >> bit) & 1) {
+            bigint_mul(dst, *tmp, x, scratch);
+        } else {
+            internal_bigint_swap(dst, tmp);
+        }
+    }
+}
+
+/**
+ * @brief
+ *      Whether `root^n = x`.
+ */
+static bool is_root_of(const BigInt &root, const BigInt &x, isize n, const Allocator &scratch)
+{
+    BigInt power = bigint_make(scratch);
+    BigInt tmp   = bigint_make(scratch);
+    bigint_pow(&power, root, n, &tmp, scratch);
+    bool ok = bigint_eq(power, x);
+    bigint_free(&tmp);
+    bigint_free(&power);
+    return ok;
+}
+
+/**
+ * @brief
+ *      Whether `x` is 0, 1 or -1, each its own root and power.
+ */
+static bool is_trivial_root(const BigInt &x)
+{
+    return len(x.digits) == 0 || (len(x.digits) == 1 && x.digits[0] == 1);
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- ROOTS -------------------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      `dst = floor(x^(1/n))` for `x > 0` and a root of up to
+ *      `ROOT_ESTIMATE_BITS` bits: a guess from `log2(x)`, which a double gets
+ *      to within one, fixed up against `x` itself.
+ */
+static void root_estimate(BigInt *dst, const BigInt &x, isize n, const Allocator &scratch)
+{
+    double estimate = std::exp2(bigint_log2(x) / static_cast<double>(n));
+    DIGIT  root     = (estimate < 1.0) ? 1 : static_cast<DIGIT>(estimate);
+
+    BigInt power = bigint_make(scratch);
+    BigInt tmp   = bigint_make(scratch);
+    BigInt guess = bigint_make(scratch);
+    for (;;) {
+        bigint_set_from_u64(&guess, root, Sign::Positive);
+        bigint_pow(&power, guess, n, &tmp, scratch);
+        if (bigint_gt(power, x)) {
+            root--;
+            continue;
+        }
+        bigint_set_from_u64(&guess, root + 1, Sign::Positive);
+        bigint_pow(&power, guess, n, &tmp, scratch);
+        if (bigint_gt(power, x)) {
+            break;
+        }
+        root++;
+    }
+    bigint_set_from_u64(dst, root, Sign::Positive);
+    bigint_free(&guess);
+    bigint_free(&tmp);
+    bigint_free(&power);
+}
+
+/**
+ * @brief
+ *      `dst = floor(x^(1/n))` for `x > 0` and `n >= 3`. `dst` may not alias
+ *      `x`.
+ *
+ * @note
+ *      With `r` the root of `x` shifted down by `n*h` bits, the root of `x`
+ *      lies in `[r 2^h, (r + 1) 2^h)`. Newton's iteration, rounded down,
+ *      decreases from any start above the root until it reaches it, so we
+ *      start from the top of that range and stop once it no longer does.
+ *      Taking `h` as half the bits of the root leaves only about `n/2` to
+ *      go after one step, and none after the next.
+ */
+static void bigint_root(BigInt *dst, const BigInt &x, isize n, const Allocator &scratch)
+{
+    isize root_bits = (bigint_bit_len(x) + n - 1) / n;
+    if (root_bits <= ROOT_ESTIMATE_BITS) {
+        root_estimate(dst, x, n, scratch);
+        return;
+    }
+    isize  low_bits = root_bits / 2;
+    BigInt high     = bigint_make(scratch);
+    internal_bigint_shr(&high, x, n*low_bits);
+    bigint_root(dst, high, n, scratch);
+    bigint_add_digit(dst, *dst, 1);
+    internal_bigint_shl(dst, *dst, low_bits);
+
+    // next = ((n - 1) dst + x / dst^(n - 1)) / n
+    BigInt power = bigint_make(scratch);
+    BigInt tmp   = bigint_make(scratch);
+    BigInt next  = bigint_make(scratch);
+    for (;;) {
+        bigint_pow(&power, *dst, n - 1, &tmp, scratch);
+        bigint_divmod(&tmp, nullptr, x, power, scratch);
+        bigint_mul_digit(&next, *dst, static_cast<DIGIT>(n - 1));
+        bigint_add(&next, next, tmp);
+        bigint_divmod_digit(&next, nullptr, next, static_cast<DIGIT>(n));
+        if (!bigint_lt(next, *dst)) {
+            break;
+        }
+        internal_bigint_swap(dst, &next);
+    }
+    bigint_free(&next);
+    bigint_free(&tmp);
+    bigint_free(&power);
+    bigint_free(&high);
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- POWERS ------------------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      An exponent `n` whose root is to be taken only if `x` is an `n`th power
+ *      modulo two primes `q = 1 (mod n)`, which a non-power manages with
+ *      probability about `1/n^2`.
+ */
+struct Power_Test {
+    isize n;
+    DIGIT q[2];
+};
+
+/**
+ * @return
+ *      false if there are no such primes with a product that fits in a digit.
+ */
+static bool power_test_init(Power_Test *self, isize n)
+{
+    self->n = n;
+    isize n_q = 0;
+    for (DIGIT q = 2*n + 1; n_q < 2 && q < (DIGIT(1) << 32); q += 2*n) {
+        if (is_small_prime(q)) {
+            self->q[n_q++] = q;
+        }
+    }
+    return n_q == 2;
+}
+
+/**
+ * @brief
+ *      Whether `x > 0` is an `n`th power for any of `tests`.
+ *
+ * @note
+ *      Reducing `x` by each modulus in turn would cost a division per digit of
+ *      `x` and modulus. One division by the product of all of them, which is
+ *      a multiplication-like pass, leaves a remainder only as long as that
+ *      product for them to share.
+ */
+static bool power_tests_run(const Power_Test *tests, isize n_tests, const BigInt &x, const Allocator &scratch)
+{
+    BigInt product = bigint_make(scratch);
+    BigInt rem     = bigint_make(scratch);
+    BigInt root    = bigint_make(scratch);
+    bigint_set_from_u64(&product, 1, Sign::Positive);
+    for (isize i = 0; i < n_tests; i++) {
+        bigint_mul_digit(&product, product, tests[i].q[0] * tests[i].q[1]);
+    }
+    bigint_divmod(nullptr, &rem, x, product, scratch);
+
+    bool found = false;
+    for (isize i = 0; i < n_tests && !found; i++) {
+        const Power_Test &test = tests[i];
+        DIGIT r = internal_mod_digit(cbegin(rem.digits), len(rem.digits), test.q[0] * test.q[1]);
+        if (is_power_residue(r, test.q[0], test.n) && is_power_residue(r, test.q[1], test.n)) {
+            bigint_root(&root, x, test.n, scratch);
+            found = is_root_of(root, x, test.n, scratch);
+        }
+    }
+    bigint_free(&root);
+    bigint_free(&rem);
+    bigint_free(&product);
+    return found;
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- PUBLIC API --------------------------------------------------------- {{{1
+
+bool bigint_isqrt(BigInt *dst, const BigInt &x)
+{
+    return bigint_isqrt(dst, x, dst->digits.allocator);
+}
+
+/**
+ * @note
+ *      Each round doubles the bits of `a`, which stays within one of the root
+ *      of the leading `2d + 1` or so bits of `x`, at the cost of a division of
+ *      the next `2d` bits by it. See CPython for the proof.
+ */
+bool bigint_isqrt(BigInt *dst, const BigInt &x, const Allocator &scratch)
+{
+    if (bigint_is_neg(x)) {
+        return false;
+    } else if (bigint_is_zero(x)) {
+        bigint_clear(dst);
+        return true;
+    }
+    isize  c = (bigint_bit_len(x) - 1) / 2;
+    isize  d = 0;
+    BigInt a = bigint_make(scratch);
+    BigInt q = bigint_make(scratch);
+    BigInt t = bigint_make(scratch);
+    bigint_set_from_u64(&a, 1, Sign::Positive);
+    for (int s = isize_bit_len(c) - 1; s >= 0; s--) {
+        isize e = d;
+        d = c >> s;
+        internal_bigint_shr(&t, x, 2*c - e - d + 1);
+        bigint_divmod(&q, nullptr, t, a, scratch);
+        internal_bigint_shl(&a, a, d - e - 1);
+        bigint_add(&a, a, q);
+    }
+    internal_bigint_sqr(&t, a, scratch);
+    if (bigint_gt(t, x)) {
+        bigint_sub_digit(&a, a, 1);
+    }
+    bigint_set(dst, a);
+    bigint_free(&t);
+    bigint_free(&q);
+    bigint_free(&a);
+    return true;
+}
+
+bool bigint_iroot(BigInt *dst, const BigInt &x, isize n)
+{
+    return bigint_iroot(dst, x, n, dst->digits.allocator);
+}
+
+bool bigint_iroot(BigInt *dst, const BigInt &x, isize n, const Allocator &scratch)
+{
+    if (n <= 0 || (n % 2 == 0 && bigint_is_neg(x))) {
+        return false;
+    } else if (n == 2) {
+        return bigint_isqrt(dst, x, scratch);
+    } else if (n == 1 || is_trivial_root(x)) {
+        bigint_set(dst, x);
+        return true;
+    }
+    BigInt mag  = bigint_make(scratch);
+    BigInt root = bigint_make(scratch);
+    bigint_abs(&mag, x);
+    bigint_root(&root, mag, n, scratch);
+    if (bigint_is_neg(x)) {
+        bigint_neg(&root, root);
+    }
+    bigint_set(dst, root);
+    bigint_free(&root);
+    bigint_free(&mag);
+    return true;
+}
+
+bool bigint_is_square(const BigInt &x)
+{
+    return bigint_is_square(x, heap_allocator);
+}
+
+bool bigint_is_square(const BigInt &x, const Allocator &scratch)
+{
+    if (bigint_is_neg(x)) {
+        return false;
+    } else if (bigint_is_zero(x)) {
+        return true;
+    } else if (!is_square_low_digit(x.digits[0])) {
+        return false;
+    }
+    DIGIT modulus = 1;
+    for (DIGIT q : SMALL_PRIMES) {
+        modulus *= q;
+    }
+    DIGIT r = internal_mod_digit(cbegin(x.digits), len(x.digits), modulus);
+    for (DIGIT q : SMALL_PRIMES) {
+        if (!is_power_residue(r, q, 2)) {
+            return false;
+        }
+    }
+    BigInt root = bigint_make(scratch);
+    bigint_isqrt(&root, x, scratch);
+    bool ok = is_root_of(root, x, 2, scratch);
+    bigint_free(&root);
+    return ok;
+}
+
+bool bigint_is_perfect_power(const BigInt &x)
+{
+    return bigint_is_perfect_power(x, heap_allocator);
+}
+
+/**
+ * @note
+ *      Only prime exponents need trying, and only those that divide the count
+ *      of trailing zeros. Roots small enough to guess in floating point are
+ *      checked against the low digit before anything else. Larger ones must
+ *      first pass the residue tests of `power_tests_run`.
+ */
+bool bigint_is_perfect_power(const BigInt &x, const Allocator &scratch)
+{
+    if (is_trivial_root(x)) {
+        return true;
+    }
+    BigInt mag = bigint_make(scratch);
+    bigint_abs(&mag, x);
+    isize bits  = bigint_bit_len(mag);
+    isize zeros = 0;
+    while (mag.digits[zeros / DIGIT_BITS] == 0) {
+        zeros += DIGIT_BITS;
+    }
+    zeros += internal_count_trailing_zeros(mag.digits[zeros / DIGIT_BITS]);
+
+    // A root of 2 or more needs `x >= 2^n`.
+    bool *composite = rawarray_new<bool>(scratch, bits);
+    internal_sieve(composite, bits);
+
+    bool       found = false;
+    BigInt     root  = bigint_make(scratch);
+    Power_Test tests[POWER_TEST_BLOCK];
+    isize      n_tests = 0;
+    // Negative numbers only have odd roots.
+    for (isize n = bigint_is_neg(x) ? 3 : 2; n < bits && !found; n++) {
+        if (composite[n] || (zeros > 0 && zeros % n != 0)) {
+            continue;
+        }
+        if (n == 2) {
+            found = bigint_is_square(mag, scratch);
+            continue;
+        }
+        isize root_bits = (bits + n - 1) / n;
+        if (root_bits <= ROOT_ESTIMATE_BITS) {
+            double estimate = std::exp2(bigint_log2(mag) / static_cast<double>(n));
+            DIGIT  guess    = static_cast<DIGIT>(std::llround(estimate));
+            for (DIGIT r = (guess > 2) ? guess - 1 : 2; r <= guess + 1 && !found; r++) {
+                if (pow_wrap(r, n) == mag.digits[0]) {
+                    bigint_set_from_u64(&root, r, Sign::Positive);
+                    found = is_root_of(root, mag, n, scratch);
+                }
+            }
+            continue;
+        }
+        if (!power_test_init(&tests[n_tests], n)) {
+            bigint_root(&root, mag, n, scratch);
+            found = is_root_of(root, mag, n, scratch);
+            continue;
+        }
+        if (++n_tests == POWER_TEST_BLOCK) {
+            found   = power_tests_run(tests, n_tests, mag, scratch);
+            n_tests = 0;
+        }
+    }
+    if (!found && n_tests > 0) {
+        found = power_tests_run(tests, n_tests, mag, scratch);
+    }
+    bigint_free(&root);
+    rawarray_free(scratch, composite, bits);
+    bigint_free(&mag);
+    return found;
+}
+
+///--- 1}}} --------------------------------------------------------------------
@@ -0,0 +1,519 @@
+#include "bigint.hpp"
+#include "bigint_internal.hpp"
+
+#include <cstring>
+
+/**
+ * @brief
+ *      Conversion between `BigInt` and text.
+ *
+ * @note
+ *      Repeatedly dividing by 10^19 is quadratic, so large numbers are instead
+ *      split in half by the powers `10^(19 * 2^k)`, recursing on the quotient
+ *      and the remainder. Each power is computed once per conversion along
+ *      with its reciprocal, so every split costs a couple of multiplications.
+ *
+ *      Parsing runs the same tree in reverse: 19-digit chunks are combined
+ *      pairwise as `lo + hi * power`, level by level.
+ */
+
+// The largest power of 10 that fits in a digit.
+static const DIGIT POW10_19      = 10000000000000000000ull;
+static const isize POW10_19_CHARS = 19;
+
+// At or below this many digits we just divide by 10^19 repeatedly.
+static const isize RADIX_BASECASE = 32;
+
+// Enough levels for numbers far larger than we could ever allocate.
+static const isize RADIX_MAX_LEVELS = 48;
+
+///--- POWER TREE --------------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      `power` is `10^chars` where `chars = 19 * 2^k` for level `k`.
+ *
+ *      Division by `power` also needs its reciprocal plus somewhere to put the
+ *      quotient and remainder, which are only allocated on first use. Because
+ *      we recurse on the quotient before the remainder, one pair per level is
+ *      enough for the whole tree.
+ */
+struct Radix_Power {
+    DIGIT *power;
+    DIGIT *inverse; // `len + 2` digits, or null until first needed.
+    DIGIT *quot;    // `len + 1` digits, allocated along with `inverse`.
+    DIGIT *rem;     // `len` digits, allocated along with `inverse`.
+    isize  len;
+    isize  cap;
+    isize  chars;
+};
+
+struct Radix_Tree {
+    Radix_Power levels[RADIX_MAX_LEVELS];
+    isize       count;
+    Allocator   allocator;
+};
+
+static void radix_tree_init(Radix_Tree *self, const Allocator &a)
+{
+    self->count     = 0;
+    self->allocator = a;
+}
+
+// Adds the next level, which is the square of the current top one.
+static const Radix_Power &radix_tree_push(Radix_Tree *self)
+{
+    assert(self->count < RADIX_MAX_LEVELS);
+    Radix_Power *level = &self->levels[self->count];
+    if (self->count == 0) {
+        level->cap      = 1;
+        level->power    = rawarray_new<DIGIT>(self->allocator, level->cap);
+        level->power[0] = POW10_19;
+        level->len      = 1;
+        level->chars    = POW10_19_CHARS;
+    } else {
+        const Radix_Power &prev = self->levels[self->count - 1];
+        level->cap   = 2*prev.len;
+        level->power = rawarray_new<DIGIT>(self->allocator, level->cap);
+        internal_mul(level->power, prev.power, prev.len, prev.power, prev.len, self->allocator);
+        level->len   = internal_normalize(level->power, level->cap);
+        level->chars = 2*prev.chars;
+    }
+    level->inverse = nullptr;
+    level->quot    = nullptr;
+    level->rem     = nullptr;
+    self->count++;
+    return *level;
+}
+
+static void radix_tree_free(Radix_Tree *self)
+{
+    const Allocator &a = self->allocator;
+    for (isize i = 0; i < self->count; i++) {
+        Radix_Power *level = &self->levels[i];
+        if (level->inverse) {
+            rawarray_free(a, level->inverse, 3*level->len + 3);
+        }
+        rawarray_free(a, level->power, level->cap);
+    }
+    self->count = 0;
+}
+
+// Returns the level at `index`, ready to be divided by.
+static const Radix_Power &radix_tree_get_divisor(Radix_Tree *self, isize index)
+{
+    assert(0 <= index && index < self->count);
+    Radix_Power *level = &self->levels[index];
+    if (!level->inverse) {
+        level->inverse = rawarray_new<DIGIT>(self->allocator, 3*level->len + 3);
+        level->quot    = level->inverse + (level->len + 2);
+        level->rem     = level->quot + (level->len + 1);
+        internal_reciprocal(level->inverse, level->power, level->len, self->allocator);
+    }
+    return *level;
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- TO STRING ---------------------------------------------------------- {{{1
+
+// Writes exactly `width` characters of `value`, zero padded on the left.
+static void radix_write_chunk(char *out, DIGIT value, isize width)
+{
+    for (isize i = width - 1; i >= 0; i--) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+}
+
+static isize radix_count_chars(DIGIT value)
+{
+    isize count = 1;
+    while (value >= 10) {
+        value /= 10;
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief
+ *      Writes `x` to `out` and returns the end of what was written. A nonzero
+ *      `width` pads with leading zeros to exactly that many characters, which
+ *      every part but the most significant needs.
+ */
+static char *radix_write_basecase(char *out, const DIGIT *x, isize x_len, isize width)
+{
+    DIGIT tmp[RADIX_BASECASE];
+    DIGIT chunks[RADIX_BASECASE + 2];
+    isize n_chunks = 0;
+    internal_copy(tmp, x, x_len);
+    while (x_len > 0) {
+        chunks[n_chunks++] = internal_div_digit(tmp, tmp, x_len, POW10_19);
+        x_len = internal_normalize(tmp, x_len);
+    }
+
+    isize i = n_chunks - 1;
+    if (width > 0) {
+        isize n_zeros = width - n_chunks*POW10_19_CHARS;
+        assert(n_zeros >= 0);
+        std::memset(out, '0', n_zeros);
+        out += n_zeros;
+    } else if (n_chunks == 0) {
+        *out++ = '0';
+    } else {
+        isize n_chars = radix_count_chars(chunks[i]);
+        radix_write_chunk(out, chunks[i--], n_chars);
+        out += n_chars;
+    }
+    for (; i >= 0; i--) {
+        radix_write_chunk(out, chunks[i], POW10_19_CHARS);
+        out += POW10_19_CHARS;
+    }
+    return out;
+}
+
+/**
+ * @brief
+ *      `x < power^2` at `index`, so splitting by `power` leaves a quotient and
+ *      remainder that are both less than the power one level down squared.
+ */
+static char *radix_write(Radix_Tree *tree, char *out, const DIGIT *x, isize x_len, isize width, isize index)
+{
+    x_len = internal_normalize(x, x_len);
+    if (x_len <= RADIX_BASECASE) {
+        return radix_write_basecase(out, x, x_len, width);
+    }
+
+    const Radix_Power &level = radix_tree_get_divisor(tree, index);
+    Comparison cmp = internal_cmp(x, x_len, level.power, level.len);
+    if (cmp == Comparison::Less) {
+        // The leading part should not start with zeros; the others must.
+        if (width > 0) {
+            isize n_zeros = width - level.chars;
+            std::memset(out, '0', n_zeros);
+            out += n_zeros;
+            width = level.chars;
+        }
+        return radix_write(tree, out, x, x_len, width, index - 1);
+    }
+
+    isize n_quot = x_len - level.len + 1;
+    internal_divmod_preinv(level.quot, level.rem, x, x_len, level.power, level.len,
+        level.inverse, tree->allocator);
+    isize quot_width = (width > 0) ? width - level.chars : 0;
+    out = radix_write(tree, out, level.quot, n_quot, quot_width, index - 1);
+    return radix_write(tree, out, level.rem, level.len, level.chars, index - 1);
+}
+
+void bigint_to_string(String_Builder *bd, const BigInt &self)
+{
+    bigint_to_string(bd, self, bd->buffer.allocator);
+}
+
+void bigint_to_string(String_Builder *bd, const BigInt &self, const Allocator &scratch)
+{
+    const DIGIT *x     = cbegin(self.digits);
+    isize        x_len = len(self.digits);
+
+    // Each digit is worth a little over 19.26 decimal digits, plus the sign.
+    isize start  = len(bd->buffer);
+    isize needed = start + 20*x_len + 2;
+    if (needed > cap(bd->buffer)) {
+        array_reserve(&bd->buffer, array_grow_cap(cap(bd->buffer), needed));
+    }
+    char *out = begin(bd->buffer) + start;
+    if (bigint_is_neg(self)) {
+        *out++ = '-';
+    }
+
+    if (x_len <= RADIX_BASECASE) {
+        out = radix_write_basecase(out, x, x_len, 0);
+    } else {
+        // Keep squaring until `x < power^2`, as `radix_write` expects.
+        Radix_Tree tree;
+        radix_tree_init(&tree, scratch);
+        while (2*radix_tree_push(&tree).len - 2 < x_len) {}
+        out = radix_write(&tree, out, x, x_len, 0, tree.count - 1);
+        radix_tree_free(&tree);
+    }
+    bd->buffer.len = out - begin(bd->buffer);
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- FROM STRING -------------------------------------------------------- {{{1
+
+static bool radix_is_alpha(char ch)
+{
+    return ('a' <= ch && ch <= 'z') || ('A' <= ch && ch <= 'Z');
+}
+
+static bool radix_is_alnum(char ch)
+{
+    return ('0' <= ch && ch <= '9') || radix_is_alpha(ch);
+}
+
+static bool radix_is_separator(char ch)
+{
+    return ch == ' ' || ch == '_' || ch == ',';
+}
+
+/**
+ * @brief
+ *      Writes the value of `ch` in `radix` to `*digit`. Returns false if `ch`
+ *      is not a valid digit in that radix.
+ */
+static bool radix_char_to_digit(char ch, int radix, DIGIT *digit)
+{
+    int value;
+    if ('0' <= ch && ch <= '9') {
+        value = ch - '0';
+    } else if ('a' <= ch && ch <= 'z') {
+        value = ch - 'a' + 10;
+    } else if ('A' <= ch && ch <= 'Z') {
+        value = ch - 'A' + 10;
+    } else {
+        return false;
+    }
+    *digit = static_cast<DIGIT>(value);
+    return value < radix;
+}
+
+/**
+ * @brief
+ *      Parses 8 decimal characters at once if they are all digits.
+ *
+ * @link
+ *      https://lemire.me/blog/2022/01/21/swar-explained-parsing-eight-digits/
+ */
+static bool radix_parse_8_digits(const char *src, DIGIT *out)
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    // The multiplications below assume the first character is the lowest byte.
+    unused(src);
+    unused(out);
+    return false;
+#else
+    u64 chunk;
+    std::memcpy(&chunk, src, size_of(chunk));
+
+    // Each byte must be in 0x30..=0x39, and adding 6 must not carry it out.
+    u64 upper = chunk & 0xF0F0F0F0F0F0F0F0ull;
+    u64 carry = ((chunk + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4;
+    if ((upper | carry) != 0x3333333333333333ull) {
+        return false;
+    }
+    // Combine adjacent digits into 2-, then 4-, then 8-digit groups.
+    chunk -= 0x3030303030303030ull;
+    chunk  = (chunk * 10) + (chunk >> 8);
+    chunk  = (((chunk & 0x000000FF000000FFull) * (100 + (1000000ull << 32)))
+            + (((chunk >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32)))) >> 32;
+    *out = chunk;
+    return true;
+#endif
+}
+
+/**
+ * @brief
+ *      Fills `out[:n_chunks]` with the 19-digit chunks of `input`, least
+ *      significant first. Assumes `input` was already validated and holds
+ *      `n_digits` digits, possibly with separators in between.
+ */
+static void radix_read_chunks(DIGIT *out, isize n_chunks, const String &input, isize n_digits)
+{
+    const char *data  = begin(input);
+    isize       n_len = len(input);
+    isize       i     = 0;
+    isize       want  = n_digits - (n_chunks - 1)*POW10_19_CHARS;
+    for (isize k = n_chunks - 1; k >= 0; k--) {
+        DIGIT value = 0;
+        while (want > 0) {
+            DIGIT group;
+            if (want >= 8 && i + 8 <= n_len && radix_parse_8_digits(data + i, &group)) {
+                value  = value*100000000 + group;
+                i     += 8;
+                want  -= 8;
+                continue;
+            }
+            char ch = data[i++];
+            if (radix_is_separator(ch)) {
+                continue;
+            }
+            value = value*10 + static_cast<DIGIT>(ch - '0');
+            want--;
+        }
+        out[k] = value;
+        want   = POW10_19_CHARS;
+    }
+}
+
+/**
+ * @brief
+ *      Turns `out[:n]`, one base-10^19 chunk per digit, into binary in place.
+ *      At level `k` each run of `2^k` digits holds a value less than `10^(19 *
+ *      2^k)`, so a pair of runs `lo + hi * 10^(19 * 2^k)` fits exactly in the
+ *      space the two took up.
+ */
+static void radix_combine_chunks(DIGIT *out, isize n, const Allocator &scratch)
+{
+    if (n <= 1) {
+        return;
+    }
+    Radix_Tree tree;
+    radix_tree_init(&tree, scratch);
+
+    isize  n_buffer = 2*n + 1;
+    DIGIT *buffer   = rawarray_new<DIGIT>(scratch, n_buffer);
+    DIGIT *hi       = buffer;
+    DIGIT *prod     = buffer + n;
+    for (isize block = 1; block < n; block *= 2) {
+        const Radix_Power &level = radix_tree_push(&tree);
+        for (isize i = 0; i + block < n; i += 2*block) {
+            DIGIT *lo     = out + i;
+            isize  n_slot = (2*block < n - i) ? 2*block : n - i;
+            isize  n_hi   = internal_normalize(lo + block, n_slot - block);
+            if (n_hi == 0) {
+                continue;
+            }
+            internal_copy(hi, lo + block, n_hi);
+            internal_mul(prod, hi, n_hi, level.power, level.len, scratch);
+            isize n_prod = internal_normalize(prod, n_hi + level.len);
+            assert(n_prod <= n_slot);
+            internal_zero(lo + block, n_slot - block);
+            DIGIT carry = internal_add(lo, lo, n_slot, prod, n_prod);
+            assert(carry == 0);
+            unused(carry);
+        }
+    }
+    rawarray_free(scratch, buffer, n_buffer);
+    radix_tree_free(&tree);
+}
+
+/**
+ * @brief
+ *      Powers of 2 need no arithmetic at all: each character is just `bits`
+ *      more bits, packed from the least significant end.
+ */
+static void radix_read_bits(DIGIT *out, isize n_out, const String &input, int radix)
+{
+    int   bits  = (radix == 2) ? 1 : (radix == 8) ? 3 : 4;
+    DIGIT acc   = 0;
+    int   n_acc = 0;
+    isize k     = 0;
+    for (isize i = len(input) - 1; i >= 0; i--) {
+        DIGIT value;
+        if (!radix_char_to_digit(input[i], radix, &value)) {
+            continue;
+        }
+        acc   |= value << n_acc;
+        n_acc += bits;
+        if (n_acc >= DIGIT_BITS) {
+            out[k++] = acc;
+            n_acc   -= DIGIT_BITS;
+            acc      = value >> (bits - n_acc);
+        }
+    }
+    if (k < n_out) {
+        out[k++] = acc;
+    }
+    internal_zero(out + k, n_out - k);
+}
+
+/**
+ * @brief
+ *      Skips leading whitespace and signs, where each `-` flips the sign, and
+ *      trailing junk. Then, if `*radix` is 0, detects it from a `0b`, `0o`,
+ *      `0d` or `0x` prefix.
+ */
+static Parse_Error radix_trim(String *input, int *radix, Sign *sign)
+{
+    isize start = 0;
+    isize stop  = len(*input);
+    *sign = Sign::Positive;
+    for (; start < stop && !radix_is_alnum((*input)[start]); start++) {
+        if ((*input)[start] == '-') {
+            *sign = (*sign == Sign::Positive) ? Sign::Negative : Sign::Positive;
+        }
+    }
+    while (stop > start && !radix_is_alnum((*input)[stop - 1])) {
+        stop--;
+    }
+
+    if (*radix == 0) {
+        *radix = 10;
+        if (stop - start > 2 && (*input)[start] == '0' && radix_is_alpha((*input)[start + 1])) {
+            switch ((*input)[start + 1]) {
+            case 'b': case 'B': *radix = 2;  break;
+            case 'o': case 'O': *radix = 8;  break;
+            case 'd': case 'D': *radix = 10; break;
+            case 'x': case 'X': *radix = 16; break;
+            default:
+                return Parse_Error::Invalid_Radix;
+            }
+            start += 2;
+        }
+    }
+    switch (*radix) {
+    case 2: case 8: case 10: case 16:
+        break;
+    default:
+        return Parse_Error::Invalid_Radix;
+    }
+    *input = string_from_slice(*input, start, stop);
+    return Parse_Error::None;
+}
+
+Parse_Error bigint_set_from_string(BigInt *self, const String &input)
+{
+    return bigint_set_from_string(self, input, 10);
+}
+
+Parse_Error bigint_set_from_string(BigInt *self, const String &input, int radix)
+{
+    return bigint_set_from_string(self, input, radix, self->digits.allocator);
+}
+
+Parse_Error bigint_set_from_string(BigInt *self, const String &input, int radix, const Allocator &scratch)
+{
+    String      line = input;
+    Sign        sign;
+    Parse_Error err  = radix_trim(&line, &radix, &sign);
+    if (err != Parse_Error::None) {
+        return err;
+    }
+
+    // Validate everything before touching `self`.
+    isize n_digits = 0;
+    for (isize i = 0; i < len(line); i++) {
+        DIGIT value;
+        if (radix_char_to_digit(line[i], radix, &value)) {
+            n_digits++;
+        } else if (!radix_is_separator(line[i])) {
+            return Parse_Error::Invalid_Digit;
+        }
+    }
+    if (n_digits == 0) {
+        bigint_clear(self);
+        return Parse_Error::None;
+    }
+
+    isize  n_len;
+    DIGIT *out;
+    if (radix == 10) {
+        n_len = (n_digits + POW10_19_CHARS - 1) / POW10_19_CHARS;
+        out   = internal_bigint_grow(self, n_len);
+        radix_read_chunks(out, n_len, line, n_digits);
+        radix_combine_chunks(out, n_len, scratch);
+    } else {
+        int bits = (radix == 2) ? 1 : (radix == 8) ? 3 : 4;
+        n_len = (n_digits*bits + DIGIT_BITS - 1) / DIGIT_BITS;
+        out   = internal_bigint_grow(self, n_len);
+        radix_read_bits(out, n_len, line, radix);
+    }
+    self->sign = sign;
+    internal_bigint_trim(self, n_len);
+    return Parse_Error::None;
+}
+
+///--- 1}}} --------------------------------------------------------------------
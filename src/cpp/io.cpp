@@ -0,0 +1,456 @@
+#include "io.hpp"
+#include "parallel.hpp"
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+    #include <io.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+///--- FILE DESCRIPTORS --------------------------------------------------- {{{1
+
+isize io_read(int fd, void *buffer, isize size)
+{
+    for (;;) {
+#if defined(_WIN32)
+        // `_read` takes an `unsigned int` count.
+        unsigned int count = (size > INT_MAX) ? INT_MAX : static_cast<unsigned int>(size);
+        isize        n     = _read(fd, buffer, count);
+#else
+        isize n = ::read(fd, buffer, static_cast<usize>(size));
+#endif
+        if (n >= 0 || errno != EINTR) {
+            return n;
+        }
+    }
+}
+
+isize io_write(int fd, const void *buffer, isize size)
+{
+    const byte *data    = static_cast<const byte *>(buffer);
+    isize       written = 0;
+    while (written < size) {
+        isize rest = size - written;
+#if defined(_WIN32)
+        unsigned int count = (rest > INT_MAX) ? INT_MAX : static_cast<unsigned int>(rest);
+        isize        n     = _write(fd, data + written, count);
+#else
+        isize n = ::write(fd, data + written, static_cast<usize>(rest));
+#endif
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        written += n;
+    }
+    return written;
+}
+
+bool io_is_terminal(int fd)
+{
+#if defined(_WIN32)
+    return _isatty(fd) != 0;
+#else
+    return ::isatty(fd) != 0;
+#endif
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- LINE READER -------------------------------------------------------- {{{1
+
+void line_reader_init(Line_Reader *self, int fd, const Allocator &a)
+{
+    line_reader_init(self, fd, a, LINE_READER_DEFAULT_BUFFER_SIZE);
+}
+
+void line_reader_init(Line_Reader *self, int fd, const Allocator &a, isize buffer_size)
+{
+    self->fd        = fd;
+    self->buffer    = rawarray_new<char>(a, buffer_size);
+    self->cap       = buffer_size;
+    self->start     = 0;
+    self->stop      = 0;
+    self->allocator = a;
+    self->eof       = false;
+    self->error     = false;
+    string_builder_init(&self->carry, a);
+}
+
+void line_reader_free(Line_Reader *self)
+{
+    rawarray_free(self->allocator, self->buffer, self->cap);
+    string_builder_free(&self->carry);
+    self->buffer = nullptr;
+    self->cap    = 0;
+    self->start  = self->stop = 0;
+}
+
+static String line_strip_cr(String line)
+{
+    if (len(line) > 0 && line[len(line) - 1] == '\r') {
+        line.len--;
+    }
+    return line;
+}
+
+bool line_reader_next(Line_Reader *self, String *line)
+{
+    string_builder_reset(&self->carry);
+    for (;;) {
+        String rest  = {self->buffer + self->start, self->stop - self->start};
+        isize  index = string_find_first_index_char(rest, '\n');
+        if (index != -1) {
+            String piece = slice(rest, 0, index);
+            self->start += index + 1;
+            if (string_builder_len(self->carry) > 0) {
+                string_builder_append_string(&self->carry, piece);
+                piece = string_builder_to_string(self->carry);
+            }
+            *line = line_strip_cr(piece);
+            return true;
+        }
+
+        // The current line goes on past this block, so hold on to what we
+        // have of it before the buffer gets overwritten.
+        string_builder_append_string(&self->carry, rest);
+        self->start = self->stop = 0;
+        if (!self->eof) {
+            isize n = io_read(self->fd, self->buffer, self->cap);
+            if (n > 0) {
+                self->stop = n;
+                continue;
+            }
+            self->eof   = true;
+            self->error = (n < 0);
+        }
+        if (string_builder_len(self->carry) == 0) {
+            return false;
+        }
+        *line = line_strip_cr(string_builder_to_string(self->carry));
+        return true;
+    }
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- MAPPED FILES ------------------------------------------------------- {{{1
+
+#if defined(_WIN32)
+
+bool mapped_file_open(Mapped_File *self, cstring path)
+{
+    self->data    = nullptr;
+    self->len     = 0;
+    self->file    = INVALID_HANDLE_VALUE;
+    self->mapping = nullptr;
+
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return false;
+    }
+    self->file = file;
+    // Mapping an empty file is an error, but viewing it is not.
+    if (size.QuadPart == 0) {
+        return true;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        mapped_file_close(self);
+        return false;
+    }
+    self->mapping = mapping;
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        mapped_file_close(self);
+        return false;
+    }
+    self->data = static_cast<const char *>(view);
+    self->len  = static_cast<isize>(size.QuadPart);
+    return true;
+}
+
+void mapped_file_close(Mapped_File *self)
+{
+    if (self->data) {
+        UnmapViewOfFile(self->data);
+    }
+    if (self->mapping) {
+        CloseHandle(self->mapping);
+    }
+    if (self->file != INVALID_HANDLE_VALUE) {
+        CloseHandle(self->file);
+    }
+    self->data    = nullptr;
+    self->len     = 0;
+    self->file    = INVALID_HANDLE_VALUE;
+    self->mapping = nullptr;
+}
+
+#else // _WIN32
+
+bool mapped_file_open(Mapped_File *self, cstring path)
+{
+    self->data = nullptr;
+    self->len  = 0;
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    // The mapping keeps the file alive on its own.
+    defer(::close(fd));
+    struct stat info;
+    if (::fstat(fd, &info) == -1) {
+        return false;
+    }
+    // Mapping an empty file is an error, but viewing it is not.
+    if (info.st_size == 0) {
+        return true;
+    }
+    usize size = static_cast<usize>(info.st_size);
+    void *view = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    ::madvise(view, size, MADV_WILLNEED);
+    self->data = static_cast<const char *>(view);
+    self->len  = static_cast<isize>(info.st_size);
+    return true;
+}
+
+void mapped_file_close(Mapped_File *self)
+{
+    if (self->data) {
+        ::munmap(const_cast<char *>(self->data), static_cast<usize>(self->len));
+    }
+    self->data = nullptr;
+    self->len  = 0;
+}
+
+#endif // _WIN32
+
+String mapped_file_to_string(const Mapped_File &self)
+{
+    return {self.data, self.len};
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- LINE INDEX --------------------------------------------------------- {{{1
+
+static isize count_newlines(const char *data, isize count)
+{
+    isize total = 0;
+    for (;;) {
+        isize index = string_find_first_index_char({data, count}, '\n');
+        if (index == -1) {
+            return total;
+        }
+        total++;
+        data  += index + 1;
+        count -= index + 1;
+    }
+}
+
+Slice<String> io_index_lines(const String &text, const Allocator &a)
+{
+    return io_index_lines(text, a, parallel_hardware_threads());
+}
+
+Slice<String> io_index_lines(const String &text, const Allocator &a, isize thread_count)
+{
+    const char *data = begin(text);
+    isize       size = len(text);
+    if (thread_count > size / LINE_INDEX_MIN_CHUNK_SIZE) {
+        thread_count = size / LINE_INDEX_MIN_CHUNK_SIZE;
+    }
+    if (thread_count > PARALLEL_MAX_THREADS) {
+        thread_count = PARALLEL_MAX_THREADS;
+    }
+    if (thread_count < 1) {
+        thread_count = 1;
+    }
+
+    // Chunk `i` covers `data[bounds[i]:bounds[i + 1]]`.
+    isize bounds[PARALLEL_MAX_THREADS + 1];
+    isize newlines[PARALLEL_MAX_THREADS + 1];
+    for (isize i = 0; i <= thread_count; i++) {
+        bounds[i] = size / thread_count * i;
+    }
+    bounds[thread_count] = size;
+
+    run_parallel(thread_count, [&](isize i) {
+        newlines[i + 1] = count_newlines(data + bounds[i], bounds[i + 1] - bounds[i]);
+    });
+    // Now `newlines[i]` is the number of newlines before chunk `i`.
+    newlines[0] = 0;
+    for (isize i = 1; i <= thread_count; i++) {
+        newlines[i] += newlines[i - 1];
+    }
+    bool  has_tail   = (size > 0 && data[size - 1] != '\n');
+    isize line_count = newlines[thread_count] + (has_tail ? 1 : 0);
+
+    Slice<String> lines = slice_make<String>(a, line_count);
+    if (line_count == 0) {
+        return lines;
+    }
+
+    // Newline number `k` ends line `k` and starts line `k + 1`. Whoever finds
+    // it only knows where line `k` ends, so for now `len` holds that offset.
+    lines[0].data = data;
+    if (has_tail) {
+        lines[line_count - 1].len = size;
+    }
+    run_parallel(thread_count, [&](isize i) {
+        isize k    = newlines[i];
+        isize stop = bounds[i + 1];
+        for (isize start = bounds[i]; start < stop; k++) {
+            isize index = string_find_first_index_char({data + start, stop - start}, '\n');
+            if (index == -1) {
+                break;
+            }
+            lines[k].len = start + index;
+            if (k + 1 < line_count) {
+                lines[k + 1].data = data + start + index + 1;
+            }
+            start += index + 1;
+        }
+    });
+
+    // Turn end offsets into lengths, dropping any '\r' before the newline.
+    run_parallel(thread_count, [&](isize i) {
+        isize start = line_count / thread_count * i;
+        isize stop  = (i == thread_count - 1) ? line_count : line_count / thread_count * (i + 1);
+        for (isize k = start; k < stop; k++) {
+            isize end = lines[k].len;
+            if (end > 0 && data[end - 1] == '\r' && data + end - 1 >= lines[k].data) {
+                end--;
+            }
+            lines[k].len = end - (lines[k].data - data);
+        }
+    });
+    return lines;
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- OUTPUT WRITER ------------------------------------------------------ {{{1
+
+void output_writer_init(Output_Writer *self, int fd, const Allocator &a)
+{
+    output_writer_init(self, fd, a, OUTPUT_WRITER_DEFAULT_THRESHOLD);
+}
+
+void output_writer_init(Output_Writer *self, int fd, const Allocator &a, isize threshold)
+{
+    self->fd            = fd;
+    self->threshold     = threshold;
+    self->synced        = 0;
+    self->line_buffered = io_is_terminal(fd);
+    self->error         = false;
+    string_builder_init(&self->buffer, a, 0, threshold);
+}
+
+void output_writer_free(Output_Writer *self)
+{
+    output_writer_flush(self);
+    string_builder_free(&self->buffer);
+}
+
+bool output_writer_flush(Output_Writer *self)
+{
+    isize size = string_builder_len(self->buffer);
+    if (size > 0 && !self->error) {
+        isize n = io_write(self->fd, cbegin(self->buffer.buffer), size);
+        self->error = (n != size);
+    }
+    string_builder_reset(&self->buffer);
+    self->synced = 0;
+    return !self->error;
+}
+
+void output_writer_sync(Output_Writer *self)
+{
+    String fresh = slice(string_builder_to_string(self->buffer), self->synced, string_builder_len(self->buffer));
+    if (string_builder_len(self->buffer) >= self->threshold
+        || (self->line_buffered && string_find_first_index_char(fresh, '\n') != -1)) {
+        output_writer_flush(self);
+    } else {
+        self->synced = string_builder_len(self->buffer);
+    }
+}
+
+void output_writer_write_char(Output_Writer *self, char ch)
+{
+    string_builder_append_char(&self->buffer, ch);
+    output_writer_sync(self);
+}
+
+void output_writer_write_string(Output_Writer *self, const String &str)
+{
+    string_builder_append_string(&self->buffer, str);
+    output_writer_sync(self);
+}
+
+void output_writer_write_cstring(Output_Writer *self, cstring c_str)
+{
+    output_writer_write_string(self, string_from_cstring(c_str));
+}
+
+static const char DECIMAL_PAIRS[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+void output_writer_write_uint(Output_Writer *self, u64 value)
+{
+    // Fill from the right; 20 digits are enough for `UINT64_MAX`.
+    char  digits[20];
+    isize i = size_of(digits);
+    while (value >= 100) {
+        u64 pair = value % 100;
+        value   /= 100;
+        i       -= 2;
+        std::memcpy(digits + i, DECIMAL_PAIRS + 2 * pair, 2);
+    }
+    if (value >= 10) {
+        i -= 2;
+        std::memcpy(digits + i, DECIMAL_PAIRS + 2 * value, 2);
+    } else {
+        digits[--i] = static_cast<char>('0' + value);
+    }
+    output_writer_write_string(self, {digits + i, size_of(digits) - i});
+}
+
+void output_writer_write_int(Output_Writer *self, i64 value)
+{
+    u64 magnitude = static_cast<u64>(value);
+    if (value < 0) {
+        string_builder_append_char(&self->buffer, '-');
+        // Negate as unsigned so that `INT64_MIN` works too.
+        magnitude = 0 - magnitude;
+    }
+    output_writer_write_uint(self, magnitude);
+}
+
+///--- 1}}} --------------------------------------------------------------------
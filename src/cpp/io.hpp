@@ -0,0 +1,187 @@
+#pragma once
+
+#include "odin.hpp"
+#include "strings.hpp"
+
+/**
+ * @brief
+ *      Thin wrappers over the OS file descriptor calls (`read(2)` and friends,
+ *      or their `_read` etc. equivalents on Windows) that retry when
+ *      interrupted. They return the number of bytes transferred, or -1 on
+ *      error.
+ */
+isize io_read(int fd, void *buffer, isize size);
+
+/**
+ * @note
+ *      Unlike `write(2)` itself, keeps going until all of `size` is written.
+ */
+isize io_write(int fd, const void *buffer, isize size);
+
+bool io_is_terminal(int fd);
+
+// The standard streams are the same descriptors everywhere, Windows included.
+#define IO_STDIN    0
+#define IO_STDOUT   1
+#define IO_STDERR   2
+
+///--- LINE READER -------------------------------------------------------- {{{1
+
+#define LINE_READER_DEFAULT_BUFFER_SIZE (1024 * 256)
+
+/**
+ * @brief
+ *      Splits the contents of a file descriptor into lines, reading it in large
+ *      blocks rather than a line at a time.
+ *
+ * @note
+ *      Lines are returned as views straight into the block buffer. Only a line
+ *      that straddles two blocks gets copied, into `carry`. Either way a line
+ *      is only valid until the next call to `line_reader_next`.
+ */
+struct Line_Reader {
+    int            fd;
+    char *         buffer;
+    isize          cap;
+    isize          start;  // first byte not yet handed out.
+    isize          stop;   // one past the last byte read into `buffer`.
+    String_Builder carry;  // start of a line continued in the next block.
+    Allocator      allocator;
+    bool           eof;
+    bool           error;
+};
+
+void line_reader_init(Line_Reader *self, int fd, const Allocator &a);
+void line_reader_init(Line_Reader *self, int fd, const Allocator &a, isize buffer_size);
+void line_reader_free(Line_Reader *self);
+
+/**
+ * @brief
+ *      Writes the next line to `*line` without its "\n" or "\r\n" ending. A
+ *      final line without a newline still counts.
+ *
+ * @return
+ *      false once there are no more lines, either because we hit end of file
+ *      or because reading failed, in which case `self->error` is set.
+ */
+bool line_reader_next(Line_Reader *self, String *line);
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- MAPPED FILES ------------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      A whole file mapped read-only into memory, so it can be viewed as one
+ *      big `String` without reading (or copying) it up front.
+ */
+struct Mapped_File {
+    const char *data;
+    isize       len;
+#if defined(_WIN32)
+    void *      file;    // HANDLE
+    void *      mapping; // HANDLE
+#endif
+};
+
+/**
+ * @return
+ *      false if `path` could not be opened or mapped. An empty file maps to an
+ *      empty view.
+ */
+bool mapped_file_open(Mapped_File *self, cstring path);
+void mapped_file_close(Mapped_File *self);
+
+String mapped_file_to_string(const Mapped_File &self);
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- LINE INDEX --------------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      Below this many bytes per thread, indexing lines is not worth spawning
+ *      threads for.
+ */
+#define LINE_INDEX_MIN_CHUNK_SIZE   (1024 * 1024)
+
+/**
+ * @brief
+ *      Splits `text` into lines the same way `Line_Reader` does, as views into
+ *      `text`. The file is cut into one chunk per thread: each thread first
+ *      counts the newlines in its chunk, then, knowing where its first line
+ *      goes, fills in its part of the index.
+ *
+ * @note
+ *      The result is allocated (from the calling thread) with `a`; free it
+ *      with `slice_free`. Uses all hardware threads unless told otherwise.
+ */
+Slice<String> io_index_lines(const String &text, const Allocator &a);
+Slice<String> io_index_lines(const String &text, const Allocator &a, isize thread_count);
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- OUTPUT WRITER ------------------------------------------------------ {{{1
+
+#define OUTPUT_WRITER_DEFAULT_THRESHOLD (1024 * 64)
+
+/**
+ * @brief
+ *      Accumulates output in `buffer` and hands it to the OS in large blocks,
+ *      rather than making a `printf` call (and taking the stdio lock) per
+ *      line.
+ *
+ * @note
+ *      The flush policy is: whenever `buffer` reaches `threshold` bytes, when
+ *      told to with `output_writer_flush` (e.g. at the end of a batch, or
+ *      before blocking on input), and when freed. If `fd` is an interactive
+ *      terminal, also after every complete line.
+ *
+ *      Anything that appends to a `String_Builder` (like `bigint_to_string`)
+ *      can write into `buffer` directly, followed by `output_writer_sync` so
+ *      the policy still applies.
+ */
+struct Output_Writer {
+    int            fd;
+    String_Builder buffer;
+    isize          threshold;
+    isize          synced;        // bytes of `buffer` the policy has seen.
+    bool           line_buffered;
+    bool           error;         // some write failed; later output is dropped.
+};
+
+void output_writer_init(Output_Writer *self, int fd, const Allocator &a);
+void output_writer_init(Output_Writer *self, int fd, const Allocator &a, isize threshold);
+
+/**
+ * @brief
+ *      Flushes whatever is left, then frees the buffer.
+ */
+void output_writer_free(Output_Writer *self);
+
+/**
+ * @return
+ *      false if this or any earlier write failed.
+ */
+bool output_writer_flush(Output_Writer *self);
+
+/**
+ * @brief
+ *      Applies the flush policy to what was appended to `self->buffer` since
+ *      the last call. The `output_writer_write_*` functions do this for you.
+ */
+void output_writer_sync(Output_Writer *self);
+
+void output_writer_write_char(Output_Writer *self, char ch);
+void output_writer_write_string(Output_Writer *self, const String &str);
+void output_writer_write_cstring(Output_Writer *self, cstring c_str);
+
+/**
+ * @brief
+ *      Formats in decimal two digits at a time, without going through
+ *      `printf`.
+ */
+void output_writer_write_int(Output_Writer *self, i64 value);
+void output_writer_write_uint(Output_Writer *self, u64 value);
+
+///--- 1}}} --------------------------------------------------------------------
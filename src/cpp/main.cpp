@@ -1,5 +1,6 @@
 #define ODIN_IMPLEMENTATION
 #include "odin.hpp"
+#include "io.hpp"
 #include "strings.hpp"
 
 #include <cstdarg>
@@ -13,50 +14,69 @@
 #define eprintfln(fmt, ...) std::fprintf(stderr, fmt "\n", __VA_ARGS__)
 #define eprintln(c_str)     std::fprintf(stderr, "%s\n", c_str)
 
-static cstring read_line(String_Builder *bd, FILE *stream)
+static void print_line(Output_Writer *out, const String &line)
 {
-    char _buf_[16];
-    Slice<char> buf{_buf_, size_of(_buf_)};
+    output_writer_write_char(out, '\'');
+    output_writer_write_string(out, line);
+    output_writer_write_cstring(out, "'\nlen=");
+    output_writer_write_int(out, len(line));
+    output_writer_write_char(out, '\n');
+}
 
-    // char buf[16];
-    for (;;) {
-        /**
-         * @brief
-         *      Handle EOF.
-         *
-         * @note
-         *      At least with my installation of the UCRT, sending EOF after
-         *      some nonzero amount of characters results in fgets() asking for
-         *      more characters. I'm unsure why that is based on reading the
-         *      source code.
-         * 
-         * @see
-         *      https://github.com/huangqinjin/ucrt/blob/master/stdio/fgets.cpp
-         */
-        if (!std::fgets(buf.data, len(buf), stream)) {
-            break;
-        }
-        isize end_index   = cstring_find_first_index_any(buf.data, "\r\n");
-        bool  has_newline = (end_index != -1);
-        if (!has_newline) {
-            end_index = len(buf) - 1;
-        }
-        string_builder_append_string(bd, string_from_slice(buf, 0, end_index));
-        if (has_newline) {
-            break;
-        }
+/**
+ * @brief
+ *      Like `print_line`, but also reports the capacity of whichever buffer
+ *      `line` lives in: the reader's block, or its carry for a line that
+ *      straddled blocks.
+ */
+static void print_line(Output_Writer *out, const String &line, const Line_Reader &reader)
+{
+    const char *data = begin(line);
+    bool in_block    = reader.buffer <= data && data <= reader.buffer + reader.cap;
+    isize cap        = in_block ? reader.cap : string_builder_cap(reader.carry);
+
+    output_writer_write_char(out, '\'');
+    output_writer_write_string(out, line);
+    output_writer_write_cstring(out, "'\nlen=");
+    output_writer_write_int(out, len(line));
+    output_writer_write_cstring(out, ", cap=");
+    output_writer_write_int(out, cap);
+    output_writer_write_char(out, '\n');
+}
+
+/**
+ * @brief
+ *      Goes over all of `path` at once rather than line by line like the REPL.
+ */
+static int run_file(cstring path)
+{
+    Mapped_File file;
+    if (!mapped_file_open(&file, path)) {
+        eprintfln("Failed to open '%s'", path);
+        return -1;
     }
-    if (std::ferror(stream) || std::feof(stream)) {
-        return nullptr;
+    defer(mapped_file_close(&file));
+
+    Slice<String> lines = io_index_lines(mapped_file_to_string(file), heap_allocator);
+    defer(slice_free(&lines, heap_allocator));
+
+    Output_Writer out;
+    output_writer_init(&out, IO_STDOUT, heap_allocator);
+    defer(output_writer_free(&out));
+    for (isize i = 0; i < len(lines); i++) {
+        print_line(&out, lines[i]);
     }
-    return string_builder_to_cstring(bd);
+    return output_writer_flush(&out) ? 0 : -1;
 }
 
 int main(int argc, cstring argv[])
 {
+    if (argc == 2) {
+        return run_file(argv[1]);
+    }
     if (argc != 1) {
         if (argc != 3) {
-            eprintfln("Usage: %s [pattern <text>]", argv[0]);
+            eprintfln("Usage: %s [<file> | pattern <text>]", argv[0]);
             return -1;
         }
         cstring needle   = argv[1];
@@ -71,21 +91,32 @@ int main(int argc, cstring argv[])
         } else {
             printfln("no character in '%s' found", needle);
         }
+        // Anything from here on bypasses stdio.
+        std::fflush(stdout);
     }
 
-    String_Builder bd;
-    string_builder_init(&bd, heap_allocator, 0, 32);
-    defer(string_builder_free(&bd));
+    Line_Reader reader;
+    line_reader_init(&reader, IO_STDIN, heap_allocator);
+    defer(line_reader_free(&reader));
 
+    Output_Writer out;
+    output_writer_init(&out, IO_STDOUT, heap_allocator);
+    defer(output_writer_free(&out));
+
+    // Only prompt a person. Piped input leaves flushing to the writer, so
+    // output goes out in blocks rather than one write per line.
+    bool interactive = io_is_terminal(IO_STDIN);
     for (;;) {
-        string_builder_reset(&bd);
-        std::printf(">>> ");
-        cstring c_str = read_line(&bd, stdin);
-        if (!c_str) {
+        if (interactive) {
+            // The prompt has no newline, and we are about to block on input.
+            output_writer_write_cstring(&out, ">>> ");
+            output_writer_flush(&out);
+        }
+        String line;
+        if (!line_reader_next(&reader, &line)) {
             break;
         }
-        std::printf("'%s'\n", c_str);
-        std::printf("len=%ti, cap=%ti\n", string_builder_len(bd), string_builder_cap(bd));
+        print_line(&out, line, reader);
     }
-    return 0;
+    return reader.error ? -1 : 0;
 }
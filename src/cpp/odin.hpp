@@ -8,6 +8,8 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <type_traits>
 
 // Uncomment this if you want array/slice indexing operations to not check.
 // #define NO_BOUNDS_CHECK
@@ -40,6 +42,32 @@ using rawptr  =       void *;
 
 isize math_next_power_of_2(isize start);
 
+/**
+ * @brief
+ *      Dynamic arrays grow their capacity by this factor (a fraction, so that
+ *      e.g. 3/2 is possible) whenever they run out, starting from
+ *      `ARRAY_MIN_CAP`. Either half may be overridden on its own.
+ */
+#ifndef ARRAY_GROWTH_NUMERATOR
+    #define ARRAY_GROWTH_NUMERATOR      2
+#endif // ARRAY_GROWTH_NUMERATOR
+
+#ifndef ARRAY_GROWTH_DENOMINATOR
+    #define ARRAY_GROWTH_DENOMINATOR    1
+#endif // ARRAY_GROWTH_DENOMINATOR
+
+#define ARRAY_MIN_CAP   8
+
+static_assert(ARRAY_GROWTH_NUMERATOR > ARRAY_GROWTH_DENOMINATOR, "arrays must actually grow");
+
+/**
+ * @brief
+ *      Capacity to grow `old_cap` to so that it holds at least `min_cap`
+ *      elements: one growth step, or straight to `min_cap` if that is not
+ *      enough, so that a big resize costs a single reallocation.
+ */
+isize array_grow_cap(isize old_cap, isize min_cap);
+
 enum class Allocator_Mode : u8 {
     Alloc,
     Resize,
@@ -56,6 +84,7 @@ struct Allocator_Proc_Args {
     isize align;    // desired alignment of the type.
     void *old_ptr;  // previous pointer to reallocate or free.
     isize old_size; // number of bytes allocated for `old_ptr`.
+    bool  zero;     // whether the bytes past `old_size` must read as 0.
 };
 
 /**
@@ -74,6 +103,10 @@ struct Allocator {
 /**
  * @brief
  *      Standard C malloc-based allocator.
+ *
+ * @note
+ *      Newly (re)allocated bytes are only zeroed when `zero` is requested,
+ *      since e.g. growing arrays overwrite them straight away anyway.
  * 
  * @warning
  *      On allocation failure, calls the standard C `abort()` function.
@@ -83,7 +116,9 @@ extern const Allocator heap_allocator;
 #endif // ODIN_NOSTDLIB
 
 void *allocator_alloc(Allocator a, isize size, isize align);
+void *allocator_alloc(Allocator a, isize size, isize align, bool zero);
 void *allocator_resize(Allocator a, void *ptr, isize old_size, isize new_size, isize align);
+void *allocator_resize(Allocator a, void *ptr, isize old_size, isize new_size, isize align, bool zero);
 void allocator_free(Allocator a, void *ptr, isize size);
 void allocator_free_all(Allocator a);
 
@@ -102,15 +137,27 @@ void rawptr_free(const Allocator &a, T *ptr)
 template<class T>
 T *rawarray_new(const Allocator &a, isize count)
 {
-    return static_cast<T *>(allocator_alloc(a, size_of(T) * count, align_of(T)));
+    return rawarray_new<T>(a, count, false);
+}
+
+template<class T>
+T *rawarray_new(const Allocator &a, isize count, bool zero)
+{
+    return static_cast<T *>(allocator_alloc(a, size_of(T) * count, align_of(T), zero));
 }
 
 template<class T>
 T *rawarray_resize(const Allocator &a, T *array, isize old_len, isize new_len)
+{
+    return rawarray_resize(a, array, old_len, new_len, false);
+}
+
+template<class T>
+T *rawarray_resize(const Allocator &a, T *array, isize old_len, isize new_len, bool zero)
 {
     isize old_size = size_of(T) * old_len;
     isize new_size = size_of(T) * new_len;
-    return static_cast<T *>(allocator_resize(a, array, old_size, new_size, align_of(T)));
+    return static_cast<T *>(allocator_resize(a, array, old_size, new_size, align_of(T), zero));
 }
 
 template<class T>
@@ -119,6 +166,48 @@ void rawarray_free(const Allocator &a, T *array, isize count)
     allocator_free(a, array, size_of(T) * count);
 }
 
+/**
+ * @brief
+ *      Copies `count` elements from `src` to `dst`, which may overlap. Types
+ *      that allow it are moved in bulk with one `memmove`.
+ */
+template<class T>
+void rawarray_copy(T *dst, const T *src, isize count)
+{
+    if constexpr (std::is_trivially_copyable<T>::value) {
+        if (count > 0) {
+            std::memmove(dst, src, size_of(T) * count);
+        }
+    } else if (dst < src) {
+        for (isize i = 0; i < count; i++) {
+            dst[i] = src[i];
+        }
+    } else {
+        for (isize i = count - 1; i >= 0; i--) {
+            dst[i] = src[i];
+        }
+    }
+}
+
+/**
+ * @brief
+ *      Value-initializes `count` elements at `dst`, i.e. sets them to `T{}`.
+ *      Types that allow it are cleared in bulk with one `memset`.
+ */
+template<class T>
+void rawarray_zero(T *dst, isize count)
+{
+    if constexpr (std::is_trivially_copyable<T>::value) {
+        if (count > 0) {
+            std::memset(dst, 0, size_of(T) * count);
+        }
+    } else {
+        for (isize i = 0; i < count; i++) {
+            dst[i] = T{};
+        }
+    }
+}
+
 /**
  * @brief
  *      A slice is a fixed-size view into some memory. It may be mutable.
@@ -177,7 +266,7 @@ Slice<T> slice(T *ptr, isize count, isize start, isize stop)
     isize    len = stop - start;
     if (len > 0) {
         out.data = ptr + start;
-        out.len  = stop;
+        out.len  = len;
     }
     return out;
 }
@@ -261,7 +350,8 @@ void array_init(Array<T> *self, const Allocator &a, isize len, isize cap)
 {
     self->allocator = a;
     if (cap > 0) {
-        self->data = rawarray_new<T>(a, cap);
+        // The first `len` elements are live, so they must start out as 0.
+        self->data = rawarray_new<T>(a, cap, len > 0);
     } else {
         self->data = nullptr;
     }
@@ -270,43 +360,58 @@ void array_init(Array<T> *self, const Allocator &a, isize len, isize cap)
 }
 
 template<class T>
-Array<T> array_make(const Allocator &a)
+Array<T> array_make(const Allocator &a, isize len, isize cap)
 {
-    return array_make(a, 0, 0);
+    Array<T> out;
+    array_init(&out, a, len, cap);
+    return out;
 }
 
 template<class T>
 Array<T> array_make(const Allocator &a, isize len)
 {
-    return array_make(a, len, len);
+    return array_make<T>(a, len, len);
 }
 
 template<class T>
-Array<T> array_make(const Allocator &a, isize len, isize cap)
+Array<T> array_make(const Allocator &a)
 {
-    Array<T> out;
-    array_init(&out, a, len, cap);
-    return out;
+    return array_make<T>(a, 0, 0);
 }
 
 template<class T>
 void array_resize(Array<T> *self, isize new_len)
 {
-    // Need to grow?
+    isize old_len = len(self);
     if (cap(self) < new_len) {
-        array_grow(self);
+        array_reserve(self, array_grow_cap(cap(self), new_len));
     }
+    // Elements we grow into are live, so zero them, whether or not they were
+    // already allocated.
+    rawarray_zero(self->data + old_len, new_len - old_len);
     self->len = new_len;
 }
 
 template<class T>
 void array_grow(Array<T> *self)
 {
-    array_reserve(self, (self->cap < 8) ? 8 : math_next_power_of_2(self->cap));
+    array_grow(self, false);
+}
+
+template<class T>
+void array_grow(Array<T> *self, bool zero)
+{
+    array_reserve(self, array_grow_cap(cap(self), cap(self) + 1), zero);
 }
 
 template<class T>
 void array_reserve(Array<T> *self, isize new_cap)
+{
+    array_reserve(self, new_cap, false);
+}
+
+template<class T>
+void array_reserve(Array<T> *self, isize new_cap, bool zero)
 {
     isize old_cap = cap(self);
     // Nothing to do
@@ -319,7 +424,8 @@ void array_reserve(Array<T> *self, isize new_cap)
         self->data,
         size_of(T) * old_cap,
         size_of(T) * new_cap,
-        align_of(T)));
+        align_of(T),
+        zero));
     self->cap  = new_cap;
 }
 
@@ -346,18 +452,19 @@ void array_append(Array<T> *self, const T &value)
     self->data[self->len++] = value;
 }
 
+/**
+ * @warning
+ *      `values` must not point into `self`, as growing may move its buffer.
+ */
 template<class T>
 void array_append(Array<T> *self, const Slice<const T> &values)
 {
     isize old_len = len(self);
     isize new_len = old_len + len(values);
     if (new_len > cap(self)) {
-        array_reserve(self, math_next_power_of_2(new_len));
-    }
-
-    for (isize i = 0; i < len(values); i++) {
-        self->data[old_len + i] = values[i];
+        array_reserve(self, array_grow_cap(cap(self), new_len));
     }
+    rawarray_copy(self->data + old_len, cbegin(values), len(values));
     self->len = new_len;
 }
 
@@ -378,6 +485,365 @@ T array_pop(Array<T> *self)
     return self->data[i];
 }
 
+///--- SMALL ARRAY -------------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      An `Array<T>` that keeps up to `N` elements inline, and only goes to its
+ *      allocator once it outgrows them. It has the same free-function API, so
+ *      it can stand in for an `Array<T>` wherever that is used by name.
+ *
+ * @note
+ *      `data` stays null while the elements are inline, which is what makes it
+ *      safe to copy a `Small_Array` around (e.g. return it by value). Always go
+ *      through `begin` and friends rather than `data`.
+ */
+template<class T, isize N>
+struct Small_Array {
+    Allocator allocator;
+    T *       data;     // spilled elements, or null while inline.
+    isize     len;
+    isize     cap;      // `N` while inline.
+    T         inline_data[N];
+
+    /**
+     * @brief
+     *      Read-write access. Returns an L-value.
+     */
+    T &operator[](isize index)
+    {
+        #if !defined(NO_BOUNDS_CHECK)
+            assert(0 <= index && index < this->len);
+        #endif
+        return begin(this)[index];
+    }
+
+    /**
+     * @brief
+     *      Read-only access. Returns an R-value.
+     */
+    const T &operator[](isize index) const
+    {
+        #if !defined(NO_BOUNDS_CHECK)
+            assert(0 <= index && index < this->len);
+        #endif
+        return cbegin(this)[index];
+    }
+};
+
+template<class T, isize N>
+isize len(const Small_Array<T, N> &self)
+{
+    return self.len;
+}
+
+template<class T, isize N>
+isize cap(const Small_Array<T, N> &self)
+{
+    return self.cap;
+}
+
+template<class T, isize N>
+T *begin(const Small_Array<T, N> &self)
+{
+    return self.data ? self.data : const_cast<T *>(self.inline_data);
+}
+
+template<class T, isize N>
+T *end(const Small_Array<T, N> &self)
+{
+    return begin(self) + self.len;
+}
+
+template<class T, isize N>
+const T *cbegin(const Small_Array<T, N> &self)
+{
+    return begin(self);
+}
+
+template<class T, isize N>
+const T *cend(const Small_Array<T, N> &self)
+{
+    return begin(self) + self.len;
+}
+
+template<class T, isize N>
+isize len(const Small_Array<T, N> *self)
+{
+    return self->len;
+}
+
+template<class T, isize N>
+isize cap(const Small_Array<T, N> *self)
+{
+    return self->cap;
+}
+
+template<class T, isize N>
+T *begin(const Small_Array<T, N> *self)
+{
+    return begin(*self);
+}
+
+template<class T, isize N>
+T *end(const Small_Array<T, N> *self)
+{
+    return end(*self);
+}
+
+template<class T, isize N>
+const T *cbegin(const Small_Array<T, N> *self)
+{
+    return begin(*self);
+}
+
+template<class T, isize N>
+const T *cend(const Small_Array<T, N> *self)
+{
+    return end(*self);
+}
+
+template<class T, isize N>
+Slice<T> slice(const Small_Array<T, N> &self, isize start, isize stop)
+{
+    return slice(begin(self), len(self), start, stop);
+}
+
+template<class T, isize N>
+void array_init(Small_Array<T, N> *self, const Allocator &a)
+{
+    array_init(self, a, 0, 0);
+}
+
+template<class T, isize N>
+void array_init(Small_Array<T, N> *self, const Allocator &a, isize len)
+{
+    array_init(self, a, len, len);
+}
+
+template<class T, isize N>
+void array_init(Small_Array<T, N> *self, const Allocator &a, isize len, isize cap)
+{
+    self->allocator = a;
+    self->data      = nullptr;
+    self->len       = 0;
+    self->cap       = N;
+    array_reserve(self, cap, len > 0);
+    if (len > 0 && !self->data) {
+        // The first `len` elements are live, so they must start out as 0.
+        rawarray_zero(self->inline_data, len);
+    }
+    self->len = len;
+}
+
+template<class T, isize N>
+void array_resize(Small_Array<T, N> *self, isize new_len)
+{
+    isize old_len = len(self);
+    if (cap(self) < new_len) {
+        array_reserve(self, array_grow_cap(cap(self), new_len));
+    }
+    // Elements we grow into are live, so zero them, whether or not they were
+    // already allocated.
+    rawarray_zero(begin(self) + old_len, new_len - old_len);
+    self->len = new_len;
+}
+
+template<class T, isize N>
+void array_grow(Small_Array<T, N> *self)
+{
+    array_grow(self, false);
+}
+
+template<class T, isize N>
+void array_grow(Small_Array<T, N> *self, bool zero)
+{
+    array_reserve(self, array_grow_cap(cap(self), cap(self) + 1), zero);
+}
+
+template<class T, isize N>
+void array_reserve(Small_Array<T, N> *self, isize new_cap)
+{
+    array_reserve(self, new_cap, false);
+}
+
+template<class T, isize N>
+void array_reserve(Small_Array<T, N> *self, isize new_cap, bool zero)
+{
+    isize old_cap = cap(self);
+    // Nothing to do
+    if (new_cap <= old_cap) {
+        return;
+    }
+
+    if (self->data) {
+        self->data = rawarray_resize(self->allocator, self->data, old_cap, new_cap, zero);
+    } else {
+        // Spilling: only the live elements need to move.
+        T *data = rawarray_new<T>(self->allocator, new_cap, zero);
+        rawarray_copy(data, self->inline_data, self->len);
+        self->data = data;
+    }
+    self->cap = new_cap;
+}
+
+/**
+ * @brief
+ *      Gives any spilled elements back to the allocator. Afterwards `self` is
+ *      empty but still usable, like a freshly initialized one.
+ */
+template<class T, isize N>
+void array_free(Small_Array<T, N> *self)
+{
+    if (self->data) {
+        rawarray_free(self->allocator, self->data, self->cap);
+    }
+    self->data = nullptr;
+    self->len  = 0;
+    self->cap  = N;
+}
+
+template<class T, isize N>
+void array_clear(Small_Array<T, N> *self)
+{
+    self->len = 0;
+}
+
+template<class T, isize N>
+void array_append(Small_Array<T, N> *self, const T &value)
+{
+    if (len(self) >= cap(self)) {
+        array_grow(self);
+    }
+    begin(self)[self->len++] = value;
+}
+
+/**
+ * @warning
+ *      `values` must not point into `self`, as growing may move its buffer.
+ */
+template<class T, isize N>
+void array_append(Small_Array<T, N> *self, const Slice<const T> &values)
+{
+    isize old_len = len(self);
+    isize new_len = old_len + len(values);
+    if (new_len > cap(self)) {
+        array_reserve(self, array_grow_cap(cap(self), new_len));
+    }
+    rawarray_copy(begin(self) + old_len, cbegin(values), len(values));
+    self->len = new_len;
+}
+
+// Promotes `Slice<T>` to a `Slice<const T>` to call the above signature.
+template<class T, isize N>
+void array_append(Small_Array<T, N> *self, const Slice<T> &values)
+{
+    array_append(self, {cbegin(values), len(values)});
+}
+
+template<class T, isize N>
+T array_pop(Small_Array<T, N> *self)
+{
+    // Can't pop if nothing to pop!
+    assert(self->len != 0);
+    isize i   = self->len - 1;
+    self->len = i;
+    return begin(self)[i];
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- DYNAMIC ARRAY ------------------------------------------------------ {{{1
+
+/**
+ * @brief
+ *      An `Array<T>` that owns its buffer: it frees it through the remembered
+ *      allocator when it goes out of scope, so no `defer(array_free(...))`.
+ *      Being an `Array<T>`, it works with all of the `array_*` functions.
+ *
+ * @note
+ *      Copying would alias the buffer and free it twice, so it is not allowed.
+ *      Move instead (e.g. return by value), which leaves the source empty but
+ *      usable, or make an explicit copy with `array_clone`.
+ */
+template<class T>
+struct Dynamic_Array : Array<T> {
+    explicit Dynamic_Array(const Allocator &a)
+    {
+        array_init(this, a);
+    }
+
+    Dynamic_Array(const Allocator &a, isize len)
+    {
+        array_init(this, a, len);
+    }
+
+    Dynamic_Array(const Allocator &a, isize len, isize cap)
+    {
+        array_init(this, a, len, cap);
+    }
+
+    Dynamic_Array(const Dynamic_Array &other) = delete;
+    Dynamic_Array &operator=(const Dynamic_Array &other) = delete;
+
+    Dynamic_Array(Dynamic_Array &&other) noexcept
+    : Array<T>{other}
+    {
+        array_init(&other, other.allocator);
+    }
+
+    Dynamic_Array &operator=(Dynamic_Array &&other) noexcept
+    {
+        if (this != &other) {
+            array_free(this);
+            Array<T>::operator=(other);
+            array_init(&other, other.allocator);
+        }
+        return *this;
+    }
+
+    ~Dynamic_Array()
+    {
+        // Moved-from (or never grown) arrays have nothing to give back.
+        if (this->data) {
+            array_free(this);
+        }
+    }
+};
+
+/**
+ * @brief
+ *      Copies the elements of `self` into a new array of its own.
+ */
+template<class T>
+Dynamic_Array<T> array_clone(const Array<T> &self, const Allocator &a)
+{
+    Dynamic_Array<T> out(a, 0, len(self));
+    array_append(&out, slice(self, 0, len(self)));
+    return out;
+}
+
+template<class T>
+Dynamic_Array<T> array_clone(const Array<T> &self)
+{
+    return array_clone(self, self.allocator);
+}
+
+/**
+ * @brief
+ *      Hands the buffer over to a plain `Array<T>`, which the caller is then
+ *      responsible for freeing, and leaves `self` empty.
+ */
+template<class T>
+Array<T> array_release(Dynamic_Array<T> *self)
+{
+    Array<T> out = *self;
+    array_init(self, self->allocator);
+    return out;
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
 ///--- GLOBAL UTILITY ----------------------------------------------------- {{{1
 
 ///--- REFERENCE ---------------------------------------------------------- {{{2
@@ -484,16 +950,6 @@ const Data *cend(const Container<Data> *self)
 
 ///--- 3}}} --------------------------------------------------------------------
 
-///--- OPERATORS ---------------------------------------------------------- {{{3
-
-template<template<class> class Container, class Data>
-bool operator==(const Container<Data> *lhs, const Container<Data> *rhs)
-{
-    return operator==<Container, Data>(*lhs, *rhs);
-}
-
-///--- 3}}} --------------------------------------------------------------------
-
 ///--- 2}}} --------------------------------------------------------------------
 
 ///--- 1}}} --------------------------------------------------------------------
@@ -530,6 +986,18 @@ isize math_next_power_of_2(isize start)
     return stop;
 }
 
+isize array_grow_cap(isize old_cap, isize min_cap)
+{
+    isize new_cap = old_cap / ARRAY_GROWTH_DENOMINATOR * ARRAY_GROWTH_NUMERATOR;
+    if (new_cap < ARRAY_MIN_CAP) {
+        new_cap = ARRAY_MIN_CAP;
+    }
+    if (new_cap < min_cap) {
+        new_cap = min_cap;
+    }
+    return new_cap;
+}
+
 #ifndef ODIN_NOSTDLIB
 
 #include <cstdio>
@@ -556,7 +1024,7 @@ void *heap_allocator_proc(void *allocator_data, Allocator_Mode mode, Allocator_P
             }
             // Loading a potentially invalid address immediately is not a safe
             // assumption for all architectures.
-            if (new_region_len > 0) {
+            if (args.zero && new_region_len > 0) {
                 byte *new_region_start = static_cast<byte *>(ptr) + args.old_size;
                 std::memset(new_region_start, 0, new_region_len);
             }
@@ -579,22 +1047,34 @@ const Allocator heap_allocator = {
 #endif // ODIN_NOSTDLIB
 
 void *allocator_alloc(Allocator a, isize size, isize align)
+{
+    return allocator_alloc(a, size, align, false);
+}
+
+void *allocator_alloc(Allocator a, isize size, isize align, bool zero)
 {
     Allocator_Proc_Args args;
     args.size     = size;
     args.align    = align;
     args.old_ptr  = nullptr;
     args.old_size = 0;
+    args.zero     = zero;
     return a.procedure(a.data, Allocator_Mode::Alloc, args);
 }
 
 void *allocator_resize(Allocator a, void *ptr, isize old_size, isize new_size, isize align)
+{
+    return allocator_resize(a, ptr, old_size, new_size, align, false);
+}
+
+void *allocator_resize(Allocator a, void *ptr, isize old_size, isize new_size, isize align, bool zero)
 {
     Allocator_Proc_Args args;
     args.size     = new_size;
     args.align    = align;
     args.old_ptr  = ptr;
     args.old_size = old_size;
+    args.zero     = zero;
     return a.procedure(a.data, Allocator_Mode::Resize, args);
 
 }
@@ -606,12 +1086,13 @@ void allocator_free(Allocator a, void *ptr, isize size)
     args.align    = 0;
     args.old_ptr  = ptr;
     args.old_size = size;
+    args.zero     = false;
     a.procedure(a.data, Allocator_Mode::Free, args);
 }
 
 void allocator_free_all(Allocator a)
 {
-    Allocator_Proc_Args args{0, 0, nullptr, 0};
+    Allocator_Proc_Args args{0, 0, nullptr, 0, false};
     a.procedure(a.data, Allocator_Mode::Free_All, args);
 }
 
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "odin.hpp"
+
+#include <thread>
+
+/**
+ * @brief
+ *      Most threads any one `run_parallel` call will run, the caller included.
+ */
+#define PARALLEL_MAX_THREADS    64
+
+/**
+ * @return
+ *      How many threads the hardware can run at once, and at least 1.
+ */
+inline isize parallel_hardware_threads()
+{
+    isize thread_count = static_cast<isize>(std::thread::hardware_concurrency());
+    return (thread_count > 0) ? thread_count : 1;
+}
+
+/**
+ * @brief
+ *      Calls `proc(i)` for each `i` in `0..<count`, each on its own thread
+ *      except for the last which runs on the calling thread. Returns once all
+ *      of them have.
+ */
+template<class Proc>
+void run_parallel(isize count, Proc proc)
+{
+    assert(1 <= count && count <= PARALLEL_MAX_THREADS);
+    std::thread threads[PARALLEL_MAX_THREADS];
+    for (isize i = 0; i < count - 1; i++) {
+        threads[i] = std::thread(proc, i);
+    }
+    proc(count - 1);
+    for (isize i = 0; i < count - 1; i++) {
+        threads[i].join();
+    }
+}
@@ -0,0 +1,390 @@
+#include "pool.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+///--- SIZE CLASSES ------------------------------------------------------- {{{1
+
+static const isize SLAB_ALIGN       = align_of(std::max_align_t);
+static const isize SLAB_HEADER_SIZE = (size_of(Pool_Slab) + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1);
+static const isize MIN_CLASS_SIZE   = static_cast<isize>(1) << POOL_MIN_CLASS_SHIFT;
+static const isize MAX_CLASS_SIZE   = static_cast<isize>(1) << POOL_MAX_CLASS_SHIFT;
+static const isize MAX_SMALL_SIZE   = POOL_SLAB_SIZE / 8;
+
+static_assert(POOL_MAX_BLOCK_ALIGN >= SLAB_ALIGN, "blocks must be at least as aligned as slabs");
+
+/**
+ * @brief
+ *      Index into `Pool::free_lists` for a request of `size` bytes, which must
+ *      not exceed `MAX_CLASS_SIZE`.
+ */
+static int class_index(isize size)
+{
+    int   index      = 0;
+    isize class_size = MIN_CLASS_SIZE;
+    while (class_size < size) {
+        class_size *= 2;
+        index++;
+    }
+    return index;
+}
+
+static isize class_size_of(int index)
+{
+    return MIN_CLASS_SIZE << index;
+}
+
+static isize block_align_of(isize block_size)
+{
+    return (block_size < POOL_MAX_BLOCK_ALIGN) ? block_size : POOL_MAX_BLOCK_ALIGN;
+}
+
+static isize align_up(isize n, isize align)
+{
+    return (n + align - 1) & ~(align - 1);
+}
+
+isize pool_class_size(isize size)
+{
+    if (size > MAX_CLASS_SIZE) {
+        return 0;
+    }
+    return class_size_of(class_index(size));
+}
+
+/**
+ * @brief
+ *      Finds the header of the slab that `ptr`, a block of class `index`,
+ *      was carved from.
+ */
+static Pool_Slab *slab_of(void *ptr, int index)
+{
+    if (class_size_of(index) > MAX_SMALL_SIZE) {
+        return reinterpret_cast<Pool_Slab *>(static_cast<byte *>(ptr) - SLAB_HEADER_SIZE);
+    }
+    std::uintptr_t mask = static_cast<std::uintptr_t>(POOL_SLAB_SIZE - 1);
+    return reinterpret_cast<Pool_Slab *>(reinterpret_cast<std::uintptr_t>(ptr) & ~mask);
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- POOL --------------------------------------------------------------- {{{1
+
+void pool_init(Pool *self, const Allocator &backing)
+{
+    self->backing = backing;
+    self->thread.store(std::this_thread::get_id(), std::memory_order_relaxed);
+    for (int i = 0; i < POOL_CLASS_COUNT; i++) {
+        self->free_lists[i] = nullptr;
+        self->remote_lists[i].store(nullptr, std::memory_order_relaxed);
+    }
+    self->slabs       = nullptr;
+    self->spare       = nullptr;
+    self->spare_count = 0;
+    self->next        = nullptr;
+}
+
+void pool_free(Pool *self)
+{
+    // Slabs of a segment are linked in after the first one, which owns the
+    // segment's memory, so they are done with by the time we free it.
+    Pool_Slab *slab = self->slabs;
+    while (slab) {
+        Pool_Slab *next = slab->next;
+        if (slab->memory) {
+            allocator_free(self->backing, slab->memory, slab->size);
+        }
+        slab = next;
+    }
+    pool_init(self, self->backing);
+}
+
+/**
+ * @brief
+ *      Gets an aligned slab for small blocks, starting a new segment if the
+ *      current one is used up.
+ */
+static Pool_Slab *pool_new_small_slab(Pool *self)
+{
+    void *memory = nullptr;
+    isize size   = 0;
+    if (self->spare_count == 0) {
+        // One slab extra so that we can align the start.
+        size   = (POOL_SEGMENT_SLABS + 1) * static_cast<isize>(POOL_SLAB_SIZE);
+        memory = allocator_alloc(self->backing, size, SLAB_ALIGN);
+        if (!memory) {
+            return nullptr;
+        }
+        std::uintptr_t mask  = static_cast<std::uintptr_t>(POOL_SLAB_SIZE - 1);
+        std::uintptr_t start = (reinterpret_cast<std::uintptr_t>(memory) + mask) & ~mask;
+        self->spare          = reinterpret_cast<byte *>(start);
+        self->spare_count    = POOL_SEGMENT_SLABS;
+    }
+    Pool_Slab *slab = reinterpret_cast<Pool_Slab *>(self->spare);
+    slab->memory = memory;
+    slab->size   = size;
+    self->spare += POOL_SLAB_SIZE;
+    self->spare_count--;
+    return slab;
+}
+
+/**
+ * @brief
+ *      Gets a new slab for class `index` and threads all of its blocks onto
+ *      the (empty) free list.
+ */
+static bool pool_refill(Pool *self, int index)
+{
+    isize      block_size = class_size_of(index);
+    byte *     blocks;
+    isize      count;
+    Pool_Slab *slab;
+    if (block_size > MAX_SMALL_SIZE) {
+        // `backing` only promises `SLAB_ALIGN`, so leave room to align the
+        // block ourselves. The header goes right before it either way.
+        isize size   = SLAB_HEADER_SIZE + block_size + POOL_MAX_BLOCK_ALIGN - SLAB_ALIGN;
+        void *memory = allocator_alloc(self->backing, size, SLAB_ALIGN);
+        if (!memory) {
+            return false;
+        }
+        std::uintptr_t start = reinterpret_cast<std::uintptr_t>(memory) + SLAB_HEADER_SIZE;
+        blocks       = reinterpret_cast<byte *>(align_up(static_cast<isize>(start), POOL_MAX_BLOCK_ALIGN));
+        count        = 1;
+        slab         = reinterpret_cast<Pool_Slab *>(blocks - SLAB_HEADER_SIZE);
+        slab->memory = memory;
+        slab->size   = size;
+    } else {
+        slab = pool_new_small_slab(self);
+        if (!slab) {
+            return false;
+        }
+        // Small slabs are aligned to their size, so padding the header out to
+        // the block alignment lines up every block.
+        isize offset = align_up(SLAB_HEADER_SIZE, block_align_of(block_size));
+        blocks       = reinterpret_cast<byte *>(slab) + offset;
+        count        = (POOL_SLAB_SIZE - offset) / block_size;
+    }
+    slab->owner = self;
+    slab->next  = self->slabs;
+    self->slabs = slab;
+
+    // Link back to front so blocks are handed out in address order.
+    Pool_Block *head   = nullptr;
+    for (isize i = count - 1; i >= 0; i--) {
+        Pool_Block *block = reinterpret_cast<Pool_Block *>(blocks + i * block_size);
+        block->next = head;
+        head        = block;
+    }
+    self->free_lists[index] = head;
+    return true;
+}
+
+static void *pool_alloc(Pool *self, isize size, isize align)
+{
+    assert(self->thread.load(std::memory_order_relaxed) == std::this_thread::get_id());
+    if (size > MAX_CLASS_SIZE) {
+        return allocator_alloc(self->backing, size, align);
+    }
+    // Blocks are aligned to `block_align_of` their class size, which covers
+    // every request no bigger than its alignment up to `POOL_MAX_BLOCK_ALIGN`.
+    // `Free` only knows the size, so anything else cannot be sent elsewhere.
+    assert(align <= block_align_of(class_size_of(class_index(size))));
+    unused(align);
+    int index = class_index(size);
+    if (!self->free_lists[index]) {
+        // Whatever other threads have given back since we last looked.
+        self->free_lists[index] = self->remote_lists[index].exchange(nullptr, std::memory_order_acquire);
+        if (!self->free_lists[index] && !pool_refill(self, index)) {
+            return nullptr;
+        }
+    }
+    Pool_Block *block = self->free_lists[index];
+    self->free_lists[index] = block->next;
+    return block;
+}
+
+/**
+ * @brief
+ *      Gives `ptr` back to whichever pool it came from, which need not be
+ *      `self` nor belong to the calling thread.
+ */
+static void pool_free_ptr(Pool *self, void *ptr, isize size)
+{
+    if (!ptr) {
+        return;
+    }
+    if (size > MAX_CLASS_SIZE) {
+        allocator_free(self->backing, ptr, size);
+        return;
+    }
+    int         index = class_index(size);
+    Pool *      owner = slab_of(ptr, index)->owner;
+    Pool_Block *block = static_cast<Pool_Block *>(ptr);
+    if (owner->thread.load(std::memory_order_relaxed) == std::this_thread::get_id()) {
+        block->next = owner->free_lists[index];
+        owner->free_lists[index] = block;
+        return;
+    }
+    std::atomic<Pool_Block *> &remote = owner->remote_lists[index];
+    block->next = remote.load(std::memory_order_relaxed);
+    while (!remote.compare_exchange_weak(block->next, block, std::memory_order_release,
+                                         std::memory_order_relaxed)) {
+    }
+}
+
+static void *pool_resize(Pool *self, void *old_ptr, isize old_size, isize size, isize align)
+{
+    if (!old_ptr) {
+        return pool_alloc(self, size, align);
+    }
+    if (old_size > MAX_CLASS_SIZE && size > MAX_CLASS_SIZE) {
+        return allocator_resize(self->backing, old_ptr, old_size, size, align);
+    }
+    // Still the same class: the block already has room.
+    if (old_size <= MAX_CLASS_SIZE && size <= MAX_CLASS_SIZE
+        && class_index(old_size) == class_index(size)) {
+        return old_ptr;
+    }
+    void *ptr = pool_alloc(self, size, align);
+    if (ptr) {
+        std::memcpy(ptr, old_ptr, (old_size < size) ? old_size : size);
+        pool_free_ptr(self, old_ptr, old_size);
+    }
+    return ptr;
+}
+
+/**
+ * @brief
+ *      Honors `args.zero` for the bytes `ptr` did not have before, which for
+ *      `Alloc` (where `old_size` is 0) is all of them.
+ */
+static void *zero_new_bytes(void *ptr, const Allocator_Proc_Args &args)
+{
+    if (ptr && args.zero && args.size > args.old_size) {
+        std::memset(static_cast<byte *>(ptr) + args.old_size, 0, args.size - args.old_size);
+    }
+    return ptr;
+}
+
+void *pool_allocator_proc(void *allocator_data, Allocator_Mode mode, Allocator_Proc_Args args)
+{
+    Pool *self = static_cast<Pool *>(allocator_data);
+    switch (mode) {
+        case Allocator_Mode::Alloc:
+            return zero_new_bytes(pool_alloc(self, args.size, args.align), args);
+        case Allocator_Mode::Resize:
+            return zero_new_bytes(pool_resize(self, args.old_ptr, args.old_size, args.size, args.align), args);
+        case Allocator_Mode::Free:
+            pool_free_ptr(self, args.old_ptr, args.old_size);
+            break;
+        case Allocator_Mode::Free_All:
+            pool_free(self);
+            break;
+    }
+    return nullptr;
+}
+
+Allocator pool_allocator(Pool *self)
+{
+    return {&pool_allocator_proc, self};
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- THREAD CACHE ------------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      Pools of threads that have exited, linked through `Pool::next`.
+ */
+static std::atomic<Pool *> orphan_pools{nullptr};
+
+static void orphans_push(Pool *first, Pool *last)
+{
+    last->next = orphan_pools.load(std::memory_order_relaxed);
+    while (!orphan_pools.compare_exchange_weak(last->next, first, std::memory_order_release,
+                                               std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief
+ *      Takes the whole list at once, which sidesteps the ABA problem of
+ *      popping a single node, and puts back what we do not need.
+ */
+static Pool *orphans_pop()
+{
+    Pool *first = orphan_pools.exchange(nullptr, std::memory_order_acquire);
+    if (!first) {
+        return nullptr;
+    }
+    Pool *rest = first->next;
+    if (rest) {
+        Pool *last = rest;
+        while (last->next) {
+            last = last->next;
+        }
+        orphans_push(rest, last);
+    }
+    first->next = nullptr;
+    return first;
+}
+
+struct Thread_Pool {
+    Pool *pool = nullptr;
+
+    ~Thread_Pool()
+    {
+        if (pool) {
+            pool->thread.store(std::thread::id(), std::memory_order_relaxed);
+            orphans_push(pool, pool);
+        }
+    }
+};
+
+static thread_local Thread_Pool thread_pool;
+
+static Pool *thread_pool_get()
+{
+    Pool *self = thread_pool.pool;
+    if (self) {
+        return self;
+    }
+    self = orphans_pop();
+    if (self) {
+        self->thread.store(std::this_thread::get_id(), std::memory_order_relaxed);
+    } else {
+        void *memory = allocator_alloc(heap_allocator, size_of(Pool), align_of(Pool));
+        self = new (memory) Pool;
+        pool_init(self, heap_allocator);
+    }
+    thread_pool.pool = self;
+    return self;
+}
+
+static void *cache_allocator_proc(void *allocator_data, Allocator_Mode mode, Allocator_Proc_Args args)
+{
+    unused(allocator_data);
+    Pool *self = thread_pool_get();
+    switch (mode) {
+        case Allocator_Mode::Alloc:
+            return zero_new_bytes(pool_alloc(self, args.size, args.align), args);
+        case Allocator_Mode::Resize:
+            return zero_new_bytes(pool_resize(self, args.old_ptr, args.old_size, args.size, args.align), args);
+        case Allocator_Mode::Free:
+            pool_free_ptr(self, args.old_ptr, args.old_size);
+            break;
+        case Allocator_Mode::Free_All:
+            // Blocks may still be in use by other threads.
+            break;
+    }
+    return nullptr;
+}
+
+const Allocator cache_allocator = {
+    &cache_allocator_proc,
+    nullptr,
+};
+
+///--- 1}}} --------------------------------------------------------------------
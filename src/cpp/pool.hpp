@@ -0,0 +1,134 @@
+#pragma once
+
+#include "odin.hpp"
+
+#include <atomic>
+#include <thread>
+
+/**
+ * @brief
+ *      Size classes are the powers of two from `1 << POOL_MIN_CLASS_SHIFT`
+ *      bytes up to `1 << POOL_MAX_CLASS_SHIFT` bytes. Anything bigger goes
+ *      straight to the backing allocator.
+ */
+#define POOL_MIN_CLASS_SHIFT    4
+#define POOL_MAX_CLASS_SHIFT    24
+#define POOL_CLASS_COUNT        (POOL_MAX_CLASS_SHIFT - POOL_MIN_CLASS_SHIFT + 1)
+
+/**
+ * @brief
+ *      Blocks of up to 1/8th of a slab are carved out of slabs aligned to
+ *      their size, which in turn are carved out of segments of
+ *      `POOL_SEGMENT_SLABS` slabs each. Bigger classes get a slab per block.
+ */
+#define POOL_SLAB_SHIFT         16
+#define POOL_SLAB_SIZE          (1 << POOL_SLAB_SHIFT)
+#define POOL_SEGMENT_SLABS      16
+
+/**
+ * @brief
+ *      Blocks are aligned to their class size, up to this many bytes (a cache
+ *      line). Any request no bigger than its alignment, as for any C++ type,
+ *      is aligned to at least that.
+ */
+#define POOL_MAX_BLOCK_ALIGN    64
+
+struct Pool;
+
+/**
+ * @brief
+ *      A free block stores the link to the next free block of its class in
+ *      its first bytes, which is why the smallest class is 16 bytes.
+ */
+struct Pool_Block {
+    Pool_Block *next;
+};
+
+/**
+ * @brief
+ *      Header in front of the blocks of one slab. For small classes it sits at
+ *      the start of the aligned slab, otherwise right before the only block,
+ *      so that any block can find the pool it belongs to.
+ */
+struct Pool_Slab {
+    Pool *     owner;
+    Pool_Slab *next;   // next slab of `owner`.
+    void *     memory; // to give back to `backing`, or null if part of a segment.
+    isize      size;   // bytes at `memory`.
+};
+
+/**
+ * @brief
+ *      A segregated-fit allocator: every request is rounded up to a power of
+ *      two and served from that size class's free list, which is refilled a
+ *      slab at a time from `backing`.
+ *
+ * @note
+ *      `Free` pushes the block back onto its class's free list, so the memory
+ *      stays with the pool until `Free_All` returns every slab to `backing`.
+ *      `Resize` within the same class returns the same pointer. Requests
+ *      bigger than the largest class are passed through to `backing` and are
+ *      not affected by `Free_All`. Memory is only zeroed on request.
+ *
+ *      Only the thread that called `pool_init` (the owner) may allocate, but
+ *      blocks may be freed from any thread: those go onto a lock-free list per
+ *      class that the owner takes over whenever it runs out of local blocks.
+ *      `backing` must be thread-safe if pass-through blocks are freed
+ *      elsewhere.
+ *
+ * @link
+ *      https://www.microsoft.com/en-us/research/publication/mimalloc-free-list-sharding-in-action/
+ */
+struct Pool {
+    Allocator                     backing;
+    std::atomic<std::thread::id>  thread;  // owner, or none while orphaned.
+    Pool_Block *                  free_lists[POOL_CLASS_COUNT];
+    std::atomic<Pool_Block *>     remote_lists[POOL_CLASS_COUNT];
+    Pool_Slab *                   slabs;
+    byte *                        spare;   // next unused slab of the current segment.
+    isize                         spare_count;
+    Pool *                        next;    // see `cache_allocator`.
+};
+
+/**
+ * @brief
+ *      Makes the calling thread the owner of `self`.
+ */
+void pool_init(Pool *self, const Allocator &backing);
+
+/**
+ * @brief
+ *      Returns every slab to the backing allocator. Any pointers obtained from
+ *      the pool, except for pass-through ones, are invalid afterwards, so no
+ *      other thread may be freeing into it at the same time.
+ */
+void pool_free(Pool *self);
+
+/**
+ * @brief
+ *      Number of bytes actually reserved for a request of `size` bytes, or 0
+ *      if `size` is bigger than the largest class.
+ */
+isize pool_class_size(isize size);
+
+void *pool_allocator_proc(void *allocator_data, Allocator_Mode mode, Allocator_Proc_Args args);
+
+/**
+ * @brief
+ *      Wraps `self` for use with `Array<T>`, `String_Builder`, `BigInt` and
+ *      friends. `self` must outlive any container using it.
+ */
+Allocator pool_allocator(Pool *self);
+
+/**
+ * @brief
+ *      Serves each thread from a pool of its own, backed by `heap_allocator`,
+ *      so allocation never synchronizes. Blocks may be freed or resized on a
+ *      different thread than the one that allocated them.
+ *
+ * @note
+ *      A thread's pool outlives the thread, since its blocks may still be in
+ *      use elsewhere, and is handed to the next thread that starts allocating.
+ *      `Free_All` does nothing.
+ */
+extern const Allocator cache_allocator;
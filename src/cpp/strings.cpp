@@ -2,14 +2,295 @@
 
 #include <cstring>
 
-isize len(cstring c_str)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define STRINGS_HAS_SSE2
+    #include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+    #define STRINGS_HAS_AVX2
+    #include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+/**
+ * @brief
+ *      The nul search below reads whole aligned blocks, which may extend past
+ *      the terminator (though never into the next page). That is fine for the
+ *      hardware but not for AddressSanitizer.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+    #define STRINGS_NO_SANITIZE __attribute__((no_sanitize_address))
+#else
+    #define STRINGS_NO_SANITIZE
+#endif
+
+///--- CHARACTER SETS ----------------------------------------------------- {{{1
+
+/**
+ * @brief
+ *      Membership table with one bit per byte value, so testing a character
+ *      costs the same no matter how big the set is.
+ */
+struct Char_Set {
+    u64 bits[4];
+};
+
+static void char_set_init(Char_Set *self, const String &set)
+{
+    self->bits[0] = self->bits[1] = self->bits[2] = self->bits[3] = 0;
+    for (isize i = 0; i < len(set); i++) {
+        u8 ch = static_cast<u8>(set[i]);
+        self->bits[ch >> 6] |= static_cast<u64>(1) << (ch & 63);
+    }
+}
+
+static bool char_set_has(const Char_Set &self, char ch)
+{
+    u8 i = static_cast<u8>(ch);
+    return (self.bits[i >> 6] >> (i & 63)) & 1;
+}
+
+#if defined(STRINGS_HAS_SSE2)
+
+/**
+ * @brief
+ *      Index of the lowest set bit of `mask`. Assumes `mask != 0`.
+ */
+static int count_trailing_zeros(u32 mask)
+{
+    assert(mask != 0);
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(mask);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    int n = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+#endif // STRINGS_HAS_SSE2
+
+/**
+ * @brief
+ *      Sets of up to this many characters are searched by comparing whole
+ *      vectors against each of them. Bigger sets go through the table one
+ *      character at a time.
+ */
+static const isize SIMD_MAX_SET_LEN = 4;
+
+/**
+ * @brief
+ *      Scans whole vectors of `self` for any character of `set` (which must
+ *      hold 1 to `SIMD_MAX_SET_LEN` characters). Returns the index of the
+ *      first match, else -1 and how far we got in `*scanned` so that the
+ *      caller can finish the tail.
+ */
+static isize find_any_simd(const String &self, const String &set, isize *scanned)
+{
+    const char *data  = begin(self);
+    isize       count = len(self);
+    isize       i     = 0;
+
+    // Pad the set by repeating its last character so the loops below always
+    // do the same number of comparisons.
+    char needles[SIMD_MAX_SET_LEN];
+    for (isize k = 0; k < SIMD_MAX_SET_LEN; k++) {
+        needles[k] = set[(k < len(set)) ? k : len(set) - 1];
+    }
+
+#if defined(STRINGS_HAS_AVX2)
+    __m256i wide[SIMD_MAX_SET_LEN];
+    for (isize k = 0; k < SIMD_MAX_SET_LEN; k++) {
+        wide[k] = _mm256_set1_epi8(needles[k]);
+    }
+    for (; i + 32 <= count; i += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        __m256i hits  = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, wide[0]), _mm256_cmpeq_epi8(block, wide[1])),
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, wide[2]), _mm256_cmpeq_epi8(block, wide[3])));
+        u32 mask = static_cast<u32>(_mm256_movemask_epi8(hits));
+        if (mask != 0) {
+            return i + count_trailing_zeros(mask);
+        }
+    }
+#endif
+
+#if defined(STRINGS_HAS_SSE2)
+    __m128i narrow[SIMD_MAX_SET_LEN];
+    for (isize k = 0; k < SIMD_MAX_SET_LEN; k++) {
+        narrow[k] = _mm_set1_epi8(needles[k]);
+    }
+    for (; i + 16 <= count; i += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        __m128i hits  = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, narrow[0]), _mm_cmpeq_epi8(block, narrow[1])),
+            _mm_or_si128(_mm_cmpeq_epi8(block, narrow[2]), _mm_cmpeq_epi8(block, narrow[3])));
+        u32 mask = static_cast<u32>(_mm_movemask_epi8(hits));
+        if (mask != 0) {
+            return i + count_trailing_zeros(mask);
+        }
+    }
+#endif
+
+    unused(data);
+    unused(count);
+    unused(needles);
+    *scanned = i;
+    return -1;
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+///--- WORD-AT-A-TIME SEARCH ---------------------------------------------- {{{1
+
+static const u64 SWAR_ONES  = 0x0101010101010101;
+static const u64 SWAR_HIGHS = 0x8080808080808080;
+
+/**
+ * @brief
+ *      Nonzero if any byte of `word` is 0. May also flag bytes above a zero
+ *      byte, so only use this to decide whether to look closer.
+ *
+ * @link
+ *      https://graphics.stanford.edu/~seander/bithacks.html#ZeroInWord
+ */
+static u64 swar_has_zero(u64 word)
+{
+    return (word - SWAR_ONES) & ~word & SWAR_HIGHS;
+}
+
+static u64 swar_load(const char *ptr)
+{
+    u64 word;
+    std::memcpy(&word, ptr, size_of(word));
+    return word;
+}
+
+/**
+ * @brief
+ *      Index of the first `ch` in `data[:count]`, else -1. Reads stay within
+ *      bounds so this works for any `String`.
+ */
+static isize find_char(const char *data, isize count, char ch)
+{
+    isize i = 0;
+
+#if defined(STRINGS_HAS_AVX2)
+    __m256i wide = _mm256_set1_epi8(ch);
+    for (; i + 32 <= count; i += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        u32     mask  = static_cast<u32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, wide)));
+        if (mask != 0) {
+            return i + count_trailing_zeros(mask);
+        }
+    }
+#endif
+
+#if defined(STRINGS_HAS_SSE2)
+    __m128i narrow = _mm_set1_epi8(ch);
+    for (; i + 16 <= count; i += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        u32     mask  = static_cast<u32>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, narrow)));
+        if (mask != 0) {
+            return i + count_trailing_zeros(mask);
+        }
+    }
+#endif
+
+    // XOR turns matching bytes into zero bytes.
+    u64 pattern = SWAR_ONES * static_cast<u8>(ch);
+    for (; i + 8 <= count; i += 8) {
+        if (swar_has_zero(swar_load(data + i) ^ pattern)) {
+            break;
+        }
+    }
+    for (; i < count; i++) {
+        if (data[i] == ch) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief
+ *      Index of the first byte in `c_str` that is either nul or one of
+ *      `needles`, found in the same pass.
+ *
+ * @note
+ *      We step byte by byte up to an aligned address first, so that the wide
+ *      reads after that can never cross a page boundary.
+ */
+STRINGS_NO_SANITIZE
+static isize cstring_scan(cstring c_str, const char (&needles)[SIMD_MAX_SET_LEN])
 {
-    const char *start = c_str;
-    const char *stop  = c_str;
-    while (stop[0] != '\0') {
-        stop++;
+    const char *ptr = c_str;
+    auto is_match = [&needles](char ch) {
+        return ch == '\0' || ch == needles[0] || ch == needles[1]
+            || ch == needles[2] || ch == needles[3];
+    };
+    while (reinterpret_cast<std::uintptr_t>(ptr) % 16 != 0) {
+        if (is_match(*ptr)) {
+            return ptr - c_str;
+        }
+        ptr++;
+    }
+
+#if defined(STRINGS_HAS_SSE2)
+    __m128i zero = _mm_setzero_si128();
+    __m128i narrow[SIMD_MAX_SET_LEN];
+    for (isize k = 0; k < SIMD_MAX_SET_LEN; k++) {
+        narrow[k] = _mm_set1_epi8(needles[k]);
+    }
+    for (;; ptr += 16) {
+        __m128i block = _mm_load_si128(reinterpret_cast<const __m128i *>(ptr));
+        __m128i hits  = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, narrow[0]), _mm_cmpeq_epi8(block, narrow[1])),
+            _mm_or_si128(_mm_cmpeq_epi8(block, narrow[2]), _mm_cmpeq_epi8(block, narrow[3])));
+        hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, zero));
+        u32 mask = static_cast<u32>(_mm_movemask_epi8(hits));
+        if (mask != 0) {
+            return (ptr - c_str) + count_trailing_zeros(mask);
+        }
+    }
+#else
+    u64 patterns[SIMD_MAX_SET_LEN];
+    for (isize k = 0; k < SIMD_MAX_SET_LEN; k++) {
+        patterns[k] = SWAR_ONES * static_cast<u8>(needles[k]);
+    }
+    for (;; ptr += 8) {
+        u64 word = swar_load(ptr);
+        u64 hits = swar_has_zero(word)
+                 | swar_has_zero(word ^ patterns[0]) | swar_has_zero(word ^ patterns[1])
+                 | swar_has_zero(word ^ patterns[2]) | swar_has_zero(word ^ patterns[3]);
+        if (hits) {
+            break;
+        }
     }
-    return stop - start;
+    while (!is_match(*ptr)) {
+        ptr++;
+    }
+    return ptr - c_str;
+#endif
+}
+
+///--- 1}}} --------------------------------------------------------------------
+
+isize len(cstring c_str)
+{
+    const char needles[SIMD_MAX_SET_LEN] = {'\0', '\0', '\0', '\0'};
+    return cstring_scan(c_str, needles);
 }
 
 String string_from_cstring(cstring c_str)
@@ -19,29 +300,45 @@ String string_from_cstring(cstring c_str)
 
 isize cstring_find_first_index_char(cstring c_str, char ch)
 {
-    return string_find_first_index_char(string_from_cstring(c_str), ch);
+    const char needles[SIMD_MAX_SET_LEN] = {ch, ch, ch, ch};
+    isize      i = cstring_scan(c_str, needles);
+    return (c_str[i] != '\0') ? i : -1;
 }
 
 isize cstring_find_first_index_any(cstring c_str, cstring set)
 {
-    return string_find_first_index_any(
-        string_from_cstring(c_str),
-        string_from_cstring(set));
+    return cstring_find_first_index_any(c_str, string_from_cstring(set));
 }
 
 isize cstring_find_first_index_any(cstring c_str, const String &set)
 {
-    return string_find_first_index_any(string_from_cstring(c_str), set);
+    // Either way the terminator is searched for along with the set, so that
+    // one pass finds whichever comes first instead of measuring `c_str` and
+    // then scanning it again.
+    if (len(set) == 0) {
+        return -1;
+    }
+    if (len(set) <= SIMD_MAX_SET_LEN) {
+        char needles[SIMD_MAX_SET_LEN];
+        for (isize k = 0; k < SIMD_MAX_SET_LEN; k++) {
+            needles[k] = set[(k < len(set)) ? k : len(set) - 1];
+        }
+        isize i = cstring_scan(c_str, needles);
+        return (c_str[i] != '\0') ? i : -1;
+    }
+    Char_Set table;
+    char_set_init(&table, set);
+    table.bits[0] |= 1;
+    isize i = 0;
+    while (!char_set_has(table, c_str[i])) {
+        i++;
+    }
+    return (c_str[i] != '\0') ? i : -1;
 }
 
 isize string_find_first_index_char(const String &self, char ch)
 {
-    for (isize i = 0; i < len(self); i++) {
-        if (self[i] == ch) {
-            return i;
-        }        
-    }
-    return -1;
+    return find_char(begin(self), len(self), ch);
 }
 
 isize string_find_first_index_any(const String &self, cstring set)
@@ -51,10 +348,24 @@ isize string_find_first_index_any(const String &self, cstring set)
 
 isize string_find_first_index_any(const String &self, const String &set)
 {
-    for (isize i = 0; i < len(set); i++) {
-        isize ii = string_find_first_index_char(self, set[i]);
-        if (ii != -1) {
-            return ii;
+    if (len(set) == 0) {
+        return -1;
+    }
+    if (len(set) == 1) {
+        return string_find_first_index_char(self, set[0]);
+    }
+    isize start = 0;
+    if (len(set) <= SIMD_MAX_SET_LEN) {
+        isize i = find_any_simd(self, set, &start);
+        if (i != -1) {
+            return i;
+        }
+    }
+    Char_Set table;
+    char_set_init(&table, set);
+    for (isize i = start; i < len(self); i++) {
+        if (char_set_has(table, self[i])) {
+            return i;
         }
     }
     return -1;
@@ -121,3 +432,47 @@ cstring string_builder_to_cstring(String_Builder *self)
     array_pop(&self->buffer);
     return cbegin(self->buffer);
 }
+
+Owned_Builder::Owned_Builder(const Allocator &a)
+{
+    string_builder_init(this, a);
+}
+
+Owned_Builder::Owned_Builder(const Allocator &a, isize len, isize cap)
+{
+    string_builder_init(this, a, len, cap);
+}
+
+Owned_Builder::Owned_Builder(Owned_Builder &&other) noexcept
+: String_Builder{other}
+{
+    // `other` keeps its allocator so that it can still be written to.
+    string_builder_init(&other, other.buffer.allocator);
+}
+
+Owned_Builder &Owned_Builder::operator=(Owned_Builder &&other) noexcept
+{
+    if (this != &other) {
+        string_builder_free(this);
+        String_Builder::operator=(other);
+        string_builder_init(&other, other.buffer.allocator);
+    }
+    return *this;
+}
+
+Owned_Builder::~Owned_Builder()
+{
+    string_builder_free(this);
+}
+
+Owned_Builder string_builder_clone(const String_Builder &self, const Allocator &a)
+{
+    Owned_Builder out(a, 0, string_builder_len(self));
+    string_builder_append_string(&out, string_builder_to_string(self));
+    return out;
+}
+
+Owned_Builder string_builder_clone(const String_Builder &self)
+{
+    return string_builder_clone(self, self.buffer.allocator);
+}
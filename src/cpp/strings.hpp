@@ -11,6 +11,13 @@
  */
 using String = Slice<const char>;
 
+/**
+ * @brief
+ *      Most strings we build (a line, a small number) fit in this many bytes,
+ *      so they never touch the allocator.
+ */
+#define STRING_BUILDER_INLINE_CAP   64
+
 /**
  * @brief
  *      A string builder simply wraps a dynamic array of `char` to be more
@@ -20,9 +27,12 @@ using String = Slice<const char>;
  *      When initializing, `len` refers to the current number of valid indexable
  *      characters. If you initialize with a nonzero `len` this will affect how
  *      things are appended.
+ *
+ *      Views returned by `string_builder_to_string` and friends may point into
+ *      the builder itself, so they do not survive copying it.
  */
 struct String_Builder {
-    Array<char> buffer;
+    Small_Array<char, STRING_BUILDER_INLINE_CAP> buffer;
 };
 
 // Global C string utility.
@@ -38,6 +48,11 @@ String string_from_slice(const Slice<T> &self, isize start, isize stop)
     return slice(static_cast<const char *>(self.data), len(self), start, stop);
 }
 
+/**
+ * @brief
+ *      Like the `String` versions below, but look for the nul terminator in
+ *      the same pass instead of measuring `c_str` first.
+ */
 isize cstring_find_first_index_char(cstring c_str, char ch);
 isize cstring_find_first_index_any(cstring c_str, cstring set);
 isize cstring_find_first_index_any(cstring c_str, const String &set);
@@ -50,8 +65,8 @@ isize string_find_first_index_char(const String &self, char ch);
 
 /**
  * @brief
- *      Return the index of the first occurence of any character in `set` within
- *      `self`, else -1.
+ *      Return the lowest index of any character in `set` within `self`, else
+ *      -1. This is a single pass over `self` regardless of `len(set)`.
  */
 isize string_find_first_index_any(const String &self, const String &set);
 isize string_find_first_index_any(const String &self, cstring set);
@@ -84,3 +99,29 @@ String string_builder_to_string(const String_Builder &self);
  *      writes to the builder.
  */
 cstring string_builder_to_cstring(String_Builder *self);
+
+/**
+ * @brief
+ *      A `String_Builder` that frees itself when it goes out of scope. Like
+ *      `Dynamic_Array<T>` it can be moved (e.g. returned by value) but not
+ *      copied; use `string_builder_clone` for an explicit copy.
+ *
+ * @warning
+ *      Moving it invalidates any views into it, since short contents live
+ *      inside the builder itself.
+ */
+struct Owned_Builder : String_Builder {
+    explicit Owned_Builder(const Allocator &a);
+    Owned_Builder(const Allocator &a, isize len, isize cap);
+
+    Owned_Builder(const Owned_Builder &other) = delete;
+    Owned_Builder &operator=(const Owned_Builder &other) = delete;
+
+    Owned_Builder(Owned_Builder &&other) noexcept;
+    Owned_Builder &operator=(Owned_Builder &&other) noexcept;
+
+    ~Owned_Builder();
+};
+
+Owned_Builder string_builder_clone(const String_Builder &self, const Allocator &a);
+Owned_Builder string_builder_clone(const String_Builder &self);